@@ -2,8 +2,9 @@ CTFDIR    =
 MPI_DIR   =
 CXX       = mpicxx -cxx=g++
 OPTS      = -O0 -g
+#add -mavx2 or -mavx512f (or -march=native on the compute nodes) to OPTS for the vectorized pattern relaxation
 #CXXFLAGS  = -std=c++0x -fopenmp $(OPTS) -Wall -DPROFILE -DPMPI -DMPIIO
-CXXFLAGS  = -std=c++0x $(OPTS) -Wall -Wno-format -DPMPI -DMPIIO
+CXXFLAGS  = -std=c++0x -fopenmp $(OPTS) -Wall -Wno-format -DPMPI -DMPIIO
 INCLUDES  = -I$(CTFDIR)/include
 LIBS      = -L$(CTFDIR)/lib -lctf -lblas generator/libgraph_generator_mpi.a -llapack -lblas 
 #LIBS      = -lctf -lblas generator/libgraph_generator_mpi.a -llapack -lblas 
@@ -1,4 +1,8 @@
 #include "connectivity.h"
+#include <limits>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // NOTE: can't use bool as return
 template <typename dtype>
@@ -16,6 +20,7 @@ int64_t are_vectors_different(CTF::Vector<dtype> & A, CTF::Vector<dtype> & B)
   }
   return s.get_val();
 }
+template int64_t are_vectors_different<int>(CTF::Vector<int> & A, CTF::Vector<int> & B);
 
 template <typename dtype>
 void max_vector(CTF::Vector<dtype> & result, CTF::Vector<dtype> & A, CTF::Vector<dtype> & B)
@@ -23,19 +28,99 @@ void max_vector(CTF::Vector<dtype> & result, CTF::Vector<dtype> & A, CTF::Vector
   result["i"] = CTF::Function<dtype,dtype,dtype>([](dtype a, dtype b){return ((a > b) ? a : b);})(A["i"], B["i"]);
 }
 
-void init_pvector(Vector<int>* p)
+// 1 if v is dense and stored cyclically on every rank, i.e. key rank + i*np at offset i of the local data,
+// and the keys of the npairs given pairs are local to this rank
+// the layout only changes when CTF remaps v for a contraction, so callers decide it once and pass it on
+template <typename T>
+int cyclic_layout(Vector<T> & v, int64_t npairs, Pair<T> const * pairs)
+{
+  int np = v.wrld->np;
+  int rank = v.wrld->rank;
+  int loc_cyclic = !v.is_sparse;
+  if (loc_cyclic){
+    int64_t v_npairs;
+    Pair<T> * v_loc_pairs;
+    v.read_local(&v_npairs, &v_loc_pairs);
+    loc_cyclic = (v_npairs == (v.len - rank + np - 1) / np);
+    for (int64_t i = 0; loc_cyclic && i < v_npairs; i++){
+      loc_cyclic = (v_loc_pairs[i].k == rank + i*np);
+    }
+    delete [] v_loc_pairs;
+  }
+  for (int64_t i = 0; loc_cyclic && i < npairs; i++){
+    loc_cyclic = (pairs[i].k % np == rank);
+  }
+  int cyclic;
+  MPI_Allreduce(&loc_cyclic, &cyclic, 1, MPI_INT, MPI_LAND, v.wrld->comm);
+  return cyclic;
+}
+
+// p[pairs[i].k] = pairs[i].d, where every key is stored on this rank
+// if p is stored cyclically (cyclic = 1, or cyclic_layout(p, npairs, pairs) if cyclic < 0), the local data is updated in place,
+// otherwise falls back to a global write
+template <typename T>
+void write_local(Vector<T> & p, int64_t npairs, Pair<T> const * pairs, int cyclic)
+{
+  if (cyclic < 0) cyclic = cyclic_layout(p, npairs, pairs);
+  if (!cyclic){
+    p.write(npairs, pairs);
+    return;
+  }
+  int np = p.wrld->np;
+  T * data;
+  int64_t size;
+  p.get_raw_data(&data, &size);
+  for (int64_t i = 0; i < npairs; i++){
+    data[pairs[i].k / np] = pairs[i].d;
+  }
+}
+
+template <typename T>
+void init_pvector(Vector<T>* p)
 {
   int64_t npairs;
-  Pair<int> * loc_pairs;
+  Pair<T> * loc_pairs;
   p->read_local(&npairs, &loc_pairs);
   for (int64_t i = 0; i < npairs; i++){
     loc_pairs[i].d = loc_pairs[i].k;
   }
-  p->write(npairs, loc_pairs);
+  write_local(*p, npairs, loc_pairs);
   delete [] loc_pairs;
 }
 
-Matrix<int>* pMatrix(Vector<int>* p, World* world)
+// vals[i] = v[loc_pairs[i].k], where loc_pairs are sorted local pairs of a vector of the same length
+// no communication is needed if every key of loc_pairs is stored locally in v on every rank, otherwise fall back to a global read
+template <typename T>
+void read_aligned(Vector<T> & v, int64_t npairs, Pair<T> const * loc_pairs, T * vals)
+{
+  int64_t v_npairs;
+  Pair<T> * v_loc_pairs;
+  v.read_local(&v_npairs, &v_loc_pairs);
+  int loc_aligned = 1;
+  int64_t j = 0;
+  for (int64_t i = 0; loc_aligned && i < npairs; i++){
+    while (j < v_npairs && v_loc_pairs[j].k < loc_pairs[i].k) j++;
+    loc_aligned = (j < v_npairs && v_loc_pairs[j].k == loc_pairs[i].k);
+    if (loc_aligned) vals[i] = v_loc_pairs[j].d;
+  }
+  int aligned;
+  MPI_Allreduce(&loc_aligned, &aligned, 1, MPI_INT, MPI_LAND, v.wrld->comm);
+  if (!aligned){
+    Pair<T> * remote_pairs = new Pair<T>[npairs];
+    for (int64_t i = 0; i < npairs; i++){
+      remote_pairs[i].k = loc_pairs[i].k;
+    }
+    v.read(npairs, remote_pairs);
+    for (int64_t i = 0; i < npairs; i++){
+      vals[i] = remote_pairs[i].d;
+    }
+    delete [] remote_pairs;
+  }
+  delete [] v_loc_pairs;
+}
+
+template <typename T>
+Matrix<T>* pMatrix(Vector<T>* p, World* world)
 {
   /*
   auto n = p->len;
@@ -46,12 +131,12 @@ Matrix<int>* pMatrix(Vector<int>* p, World* world)
   */
   // FIXME: below is not benchmarked, nor sure if this is the right way of doing it
   int64_t n = p->len;
-  auto A = new Matrix<int>(n, n, SP|SY, *world, MAX_TIMES_SR);
+  auto A = new Matrix<T>(n, n, SP|SY, *world, max_times_sr<T>());
   int64_t npairs;
-  Pair<int> * loc_pairs;
+  Pair<T> * loc_pairs;
   p->read_local(&npairs, &loc_pairs);
   int64_t *gIndex = new int64_t[npairs];
-  int *gData = new int[npairs];
+  T *gData = new T[npairs];
   for (int64_t i = 0; i < npairs; i++){
     gIndex[i] = loc_pairs[i].k + loc_pairs[i].d * n;
     gData[i] = 1;
@@ -63,14 +148,81 @@ Matrix<int>* pMatrix(Vector<int>* p, World* world)
   return A;
 }
 
-// p[i] = rec_p[q[i]]
+// vals[i] = rec_p[loc_pairs[i].d], querying each distinct parent only once
+template <typename T>
+void read_parents(Vector<T> & rec_p, int64_t npairs, Pair<T> const * loc_pairs, T * vals)
+{
+  int64_t * keys = new int64_t[npairs];
+  for (int64_t i = 0; i < npairs; i++){
+    keys[i] = loc_pairs[i].d;
+  }
+  std::sort(keys, keys + npairs);
+  int64_t nkeys = std::unique(keys, keys + npairs) - keys;
+  Pair<T> * remote_pairs = new Pair<T>[nkeys];
+  for (int64_t i = 0; i < nkeys; i++){
+    remote_pairs[i].k = keys[i];
+  }
+  rec_p.read(nkeys, remote_pairs);
+  //scatter the answers back to every vertex with that parent
+  for (int64_t i = 0; i < npairs; i++){
+    vals[i] = remote_pairs[std::lower_bound(keys, keys + nkeys, (int64_t)loc_pairs[i].d) - keys].d;
+  }
+  delete [] keys;
+  delete [] remote_pairs;
+}
+
+// p[i] = max(p[i], s[i]), returns the local number of entries of p that changed, cyclic is passed on to write_local
+template <typename T>
+int64_t max_update(Vector<T> & p, Vector<T> & s, int cyclic)
+{
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  p.read_local(&npairs, &loc_pairs);
+  T * s_vals = new T[npairs];
+  read_aligned(s, npairs, loc_pairs, s_vals);
+  int64_t nchanged = 0;
+  for (int64_t i = 0; i < npairs; i++){
+    if (s_vals[i] > loc_pairs[i].d){
+      loc_pairs[nchanged].k = loc_pairs[i].k;
+      loc_pairs[nchanged].d = s_vals[i];
+      nchanged++;
+    }
+  }
+  write_local(p, nchanged, loc_pairs, cyclic);
+  delete [] s_vals;
+  delete [] loc_pairs;
+  return nchanged;
+}
+
+// global number of entries where q differs from p, compared locally and reduced once
+template <typename T>
+int64_t count_changed(Vector<T> & q, Vector<T> & p)
+{
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  q.get_local_pairs(&npairs, &loc_pairs, q.is_sparse);
+  T * p_vals = new T[npairs];
+  read_aligned(p, npairs, loc_pairs, p_vals);
+  int64_t loc_nchanged = 0;
+  for (int64_t i = 0; i < npairs; i++){
+    loc_nchanged += (loc_pairs[i].d != p_vals[i]);
+  }
+  int64_t nchanged;
+  MPI_Allreduce(&loc_nchanged, &nchanged, 1, MPI_LONG_LONG, MPI_SUM, q.wrld->comm);
+  delete [] p_vals;
+  delete [] loc_pairs;
+  return nchanged;
+}
+
+// p[i] = rec_p[q[i]], returns the local number of i with rec_p[q[i]] != q[i], i.e. the entries of p that changed if p = q
 // if create_nonleaves=true, computing non-leaf vertices in parent forest
-void shortcut(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, Vector<int> ** nonleaves, bool create_nonleaves)
+template <typename T>
+int64_t shortcut(Vector<T> & p, Vector<T> & q, Vector<T> & rec_p, Vector<T> ** nonleaves, bool create_nonleaves)
 {
   Timer t_shortcut("CONNECTIVITY_Shortcut");
   t_shortcut.start();
   int64_t npairs;
-  Pair<int> * loc_pairs;
+  Pair<T> * loc_pairs;
   if (q.is_sparse){
     //if we have updated only a subset of the vertices
     q.get_local_pairs(&npairs, &loc_pairs, true);
@@ -78,52 +230,202 @@ void shortcut(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, Vector<int>
     //if we have potentially updated all the vertices
     q.get_local_pairs(&npairs, &loc_pairs);
   }
-  Pair<int> * remote_pairs = new Pair<int>[npairs];
-  for (int64_t i=0; i<npairs; i++){
-    remote_pairs[i].k = loc_pairs[i].d;
-  }
+  T * remote_vals = new T[npairs];
   Timer t_shortcut_read("CONNECTIVITY_Shortcut_read");
   t_shortcut_read.start();
-  rec_p.read(npairs, remote_pairs); //obtains rec_p[q[i]]
+  read_parents(rec_p, npairs, loc_pairs, remote_vals); //obtains rec_p[q[i]]
   t_shortcut_read.stop();
+  int64_t nchanged = 0;
   for (int64_t i=0; i<npairs; i++){
-    loc_pairs[i].d = remote_pairs[i].d; //p[i] = rec_p[q[i]]
+    nchanged += (loc_pairs[i].d != remote_vals[i]);
+    loc_pairs[i].d = remote_vals[i]; //p[i] = rec_p[q[i]]
   }
-  delete [] remote_pairs;
-  p.write(npairs, loc_pairs); //enter data into p[i]
+  delete [] remote_vals;
+  write_local(p, npairs, loc_pairs); //enter data into p[i]
   
   //prune out leaves
   if (create_nonleaves){
-    *nonleaves = new Vector<int>(p.len, *p.wrld, *p.sr);
+    *nonleaves = new Vector<T>(p.len, *p.wrld, *p.sr);
     //set nonleaves[i] = max_j p[j], i.e. set nonleaves[i] = 1 if i has child, i.e. is nonleaf
     for (int64_t i=0; i<npairs; i++){
       loc_pairs[i].k = loc_pairs[i].d;
       loc_pairs[i].d = 1;
     }
-    //FIXME: here and above potential optimization is to avoid duplicate queries to parent
-    (*nonleaves)->write(npairs, loc_pairs);
+    //write each parent once
+    int64_t nparents = unique_pairs(npairs, loc_pairs);
+    (*nonleaves)->write(nparents, loc_pairs);
     (*nonleaves)->operator[]("i") = (*nonleaves)->operator[]("i")*p["i"];
     (*nonleaves)->sparsify();
   }
   
   delete [] loc_pairs;
   t_shortcut.stop();
+  return nchanged;
+}
+
+// same as shortcut, but the local pairs are split into nchunks chunks and the parents of chunk c+1 are sent
+// while the answers for chunk c are in flight, requires rec_p to be dense and distributed cyclically, otherwise falls back to shortcut
+template <typename T>
+int64_t shortcut_pipelined(Vector<T> & p, Vector<T> & q, Vector<T> & rec_p, int nchunks, Vector<T> ** nonleaves, bool create_nonleaves)
+{
+  World * world = rec_p.wrld;
+  int np = world->np;
+  int rank = world->rank;
+  int64_t r_npairs;
+  Pair<T> * r_loc_pairs;
+  rec_p.read_local(&r_npairs, &r_loc_pairs);
+  int loc_aligned = !rec_p.is_sparse;
+  for (int64_t i = 0; loc_aligned && i < r_npairs; i++){
+    loc_aligned = (r_loc_pairs[i].k == rank + i*np);
+  }
+  int aligned;
+  MPI_Allreduce(&loc_aligned, &aligned, 1, MPI_INT, MPI_LAND, world->comm);
+  if (!aligned){
+    delete [] r_loc_pairs;
+    return shortcut(p, q, rec_p, nonleaves, create_nonleaves);
+  }
+  Timer t_shortcut("CONNECTIVITY_Shortcut_pipelined");
+  t_shortcut.start();
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  if (q.is_sparse){
+    q.get_local_pairs(&npairs, &loc_pairs, true);
+  } else {
+    q.get_local_pairs(&npairs, &loc_pairs);
+  }
+  int64_t csize = (npairs + nchunks - 1) / nchunks;
+  int * send_counts = new int[np*nchunks];
+  int * send_displs = new int[np*nchunks];
+  int * recv_counts = new int[np*nchunks];
+  int * recv_displs = new int[np*nchunks];
+  T ** keys = new T*[nchunks];
+  T ** serve = new T*[nchunks];
+  T ** vals = new T*[nchunks];
+  MPI_Request * key_reqs = new MPI_Request[nchunks];
+  MPI_Request * val_reqs = new MPI_Request[nchunks];
+  auto owner_less = [np](T a, T b){ return a % np < b % np || (a % np == b % np && a < b); };
+
+  //distinct parents of every chunk, grouped by owner
+  int * chunk_counts = new int[np*nchunks];
+  for (int c = 0; c < nchunks; c++){
+    int64_t lo = std::min(npairs, c*csize);
+    int64_t hi = std::min(npairs, (c+1)*csize);
+    int64_t nkeys = 0;
+    keys[c] = new T[hi - lo];
+    for (int64_t i = lo; i < hi; i++){
+      keys[c][nkeys++] = loc_pairs[i].d;
+    }
+    std::sort(keys[c], keys[c] + nkeys, owner_less);
+    nkeys = std::unique(keys[c], keys[c] + nkeys) - keys[c];
+    int * sc = send_counts + c*np;
+    std::fill(sc, sc + np, 0);
+    for (int64_t i = 0; i < nkeys; i++){
+      sc[keys[c][i] % np]++;
+    }
+    for (int i = 0; i < np; i++){
+      chunk_counts[i*nchunks + c] = sc[i];
+    }
+  }
+  //the counts of all chunks are exchanged at once, so posting a chunk does not synchronize the ranks
+  int * chunk_recv = new int[np*nchunks];
+  MPI_Alltoall(chunk_counts, nchunks, MPI_INT, chunk_recv, nchunks, MPI_INT, world->comm);
+  for (int c = 0; c < nchunks; c++){
+    int * sc = send_counts + c*np;
+    int * sd = send_displs + c*np;
+    int * rc = recv_counts + c*np;
+    int * rd = recv_displs + c*np;
+    int64_t nserve = 0;
+    for (int i = 0; i < np; i++){
+      rc[i] = chunk_recv[i*nchunks + c];
+      sd[i] = (i == 0) ? 0 : sd[i-1] + sc[i-1];
+      rd[i] = nserve;
+      nserve += rc[i];
+    }
+    serve[c] = new T[nserve];
+    vals[c] = new T[sd[np-1] + sc[np-1]];
+  }
+  delete [] chunk_counts;
+  delete [] chunk_recv;
+  //send the distinct parents of chunk c to their owners
+  auto post = [&](int c){
+    MPI_Ialltoallv(keys[c], send_counts + c*np, send_displs + c*np, mpi_type<T>(), serve[c], recv_counts + c*np, recv_displs + c*np, mpi_type<T>(), world->comm, &key_reqs[c]);
+  };
+  //answer the parents other ranks asked for in chunk c
+  auto answer = [&](int c){
+    MPI_Wait(&key_reqs[c], MPI_STATUS_IGNORE);
+    int * rc = recv_counts + c*np;
+    int64_t nserve = recv_displs[c*np + np - 1] + rc[np - 1];
+    for (int64_t i = 0; i < nserve; i++){
+      serve[c][i] = r_loc_pairs[serve[c][i] / np].d;
+    }
+    MPI_Ialltoallv(serve[c], rc, recv_displs + c*np, mpi_type<T>(), vals[c], send_counts + c*np, send_displs + c*np, mpi_type<T>(), world->comm, &val_reqs[c]);
+  };
+
+  int64_t nchanged = 0;
+  post(0);
+  for (int c = 0; c < nchunks; c++){
+    answer(c);
+    if (c + 1 < nchunks) post(c + 1);
+    MPI_Wait(&val_reqs[c], MPI_STATUS_IGNORE);
+    int * sc = send_counts + c*np;
+    int * sd = send_displs + c*np;
+    for (int64_t i = std::min(npairs, c*csize); i < std::min(npairs, (c+1)*csize); i++){
+      T par = loc_pairs[i].d;
+      T * pos = std::lower_bound(keys[c] + sd[par % np], keys[c] + sd[par % np] + sc[par % np], par);
+      nchanged += (vals[c][pos - keys[c]] != par);
+      loc_pairs[i].d = vals[c][pos - keys[c]]; //p[i] = rec_p[q[i]]
+    }
+    delete [] keys[c];
+    delete [] serve[c];
+    delete [] vals[c];
+  }
+  write_local(p, npairs, loc_pairs); //enter data into p[i]
+
+  //prune out leaves
+  if (create_nonleaves){
+    *nonleaves = new Vector<T>(p.len, *p.wrld, *p.sr);
+    for (int64_t i=0; i<npairs; i++){
+      loc_pairs[i].k = loc_pairs[i].d;
+      loc_pairs[i].d = 1;
+    }
+    int64_t nparents = unique_pairs(npairs, loc_pairs);
+    (*nonleaves)->write(nparents, loc_pairs);
+    (*nonleaves)->operator[]("i") = (*nonleaves)->operator[]("i")*p["i"];
+    (*nonleaves)->sparsify();
+  }
+
+  delete [] send_counts;
+  delete [] send_displs;
+  delete [] recv_counts;
+  delete [] recv_displs;
+  delete [] keys;
+  delete [] serve;
+  delete [] vals;
+  delete [] key_reqs;
+  delete [] val_reqs;
+  delete [] loc_pairs;
+  delete [] r_loc_pairs;
+  t_shortcut.stop();
+  return nchanged;
 }
 
-// p[i] = rec_p[q[i]]
+// p[i] = rec_p[q[i]], returns the local number of i with rec_p[q[i]] != q[i]
 // if create_nonleaves=true, computing non-leaf vertices in parent forest
-void shortcut2(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, int sc2, World * world, Vector<int> ** nonleaves, bool create_nonleaves)
+template <typename T>
+int64_t shortcut2(Vector<T> & p, Vector<T> & q, Vector<T> & rec_p, int sc2, World * world, Vector<T> ** nonleaves, bool create_nonleaves)
 {
   if (!sc2) { // run unoptimized shortcut
-    shortcut(p, q, rec_p, nonleaves, create_nonleaves);
-    return;
+    return shortcut(p, q, rec_p, nonleaves, create_nonleaves);
+  }
+  if (sc2 == 2) { // overlap the exchanges of consecutive chunks
+    return shortcut_pipelined(p, q, rec_p, 4, nonleaves, create_nonleaves);
   }
 
   Timer t_shortcut2("CONNECTIVITY2_Shortcut");
   t_shortcut2.start();
   
   int64_t rec_p_npairs;
-  Pair<int> * rec_p_loc_pairs;
+  Pair<T> * rec_p_loc_pairs;
   if (rec_p.is_sparse) {
     rec_p.get_local_pairs(&rec_p_npairs, &rec_p_loc_pairs, true);
   } else {
@@ -131,7 +433,7 @@ void shortcut2(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, int sc2, W
   }
   
   int64_t q_npairs;
-  Pair<int> * q_loc_pairs;
+  Pair<T> * q_loc_pairs;
   bool delete_p = true;
   if (&q == &rec_p) {
     q_npairs = rec_p_npairs;
@@ -148,72 +450,66 @@ void shortcut2(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, int sc2, W
     }
   }
   
+  int64_t nchanged = 0;
   int64_t * global_roots_num = new int64_t;
   int64_t * loc_roots_num = new int64_t;
   roots_num(rec_p_npairs, rec_p_loc_pairs, loc_roots_num, global_roots_num, world);
   
-  if (*global_roots_num < 1000) {
-    int * global_roots = new int[*global_roots_num];
-    roots(rec_p_npairs, *loc_roots_num, rec_p_loc_pairs, global_roots_num, global_roots, world);
-    
+  {
     int64_t * nontriv_loc_indices;
     int64_t * loc_nontriv_num = new int64_t;
-    create_nontriv_loc_indices(nontriv_loc_indices, loc_nontriv_num, global_roots_num, global_roots, q_npairs, q_loc_pairs, world);
+    if (*global_roots_num < (rec_p.len + 31) / 32) { // the root array is smaller than the bitmap
+      T * global_roots = new T[*global_roots_num];
+      roots(rec_p_npairs, *loc_roots_num, rec_p_loc_pairs, global_roots_num, global_roots, world);
+      create_nontriv_loc_indices(nontriv_loc_indices, loc_nontriv_num, global_roots_num, global_roots, q_npairs, q_loc_pairs, world);
+      delete [] global_roots;
+    } else {
+      // a Bloom filter would be smaller, but a false positive would skip a vertex whose parent is not a root
+      uint32_t * root_bits = new uint32_t[(rec_p.len + 31) / 32];
+      roots_bitmap(rec_p_npairs, rec_p_loc_pairs, rec_p.len, root_bits, world);
+      create_nontriv_loc_indices_bitmap(nontriv_loc_indices, loc_nontriv_num, root_bits, q_npairs, q_loc_pairs);
+      delete [] root_bits;
+    }
 
-    Pair<int> * nontriv_loc_pairs = new Pair<int>[*loc_nontriv_num];
-    Pair<int> * remote_pairs = new Pair<int>[*loc_nontriv_num];
+    Pair<T> * nontriv_loc_pairs = new Pair<T>[*loc_nontriv_num];
+    T * remote_vals = new T[*loc_nontriv_num];
     for (int64_t i = 0; i < *loc_nontriv_num; i++) {
       int64_t nontriv_index = nontriv_loc_indices[i];
       nontriv_loc_pairs[i] = q_loc_pairs[nontriv_index];
-      remote_pairs[i].k = q_loc_pairs[nontriv_index].d;
     }
   
     Timer t_shortcut2_read("CONNECTIVITY_Shortcut2_read");
     t_shortcut2_read.start();
-    rec_p.read(*loc_nontriv_num, remote_pairs); //obtains rec_p[q[i]]
+    read_parents(rec_p, *loc_nontriv_num, nontriv_loc_pairs, remote_vals); //obtains rec_p[q[i]]
     t_shortcut2_read.stop();
     for(int64_t i = 0; i < *loc_nontriv_num; i++) {
-      nontriv_loc_pairs[i].d = remote_pairs[i].d;
+      nontriv_loc_pairs[i].d = remote_vals[i];
     }
     
     for (int64_t i = 0; i < *loc_nontriv_num; i++) { // update loc_pairs for create_nonleaves step
       int64_t nontriv_index = nontriv_loc_indices[i];
-      q_loc_pairs[nontriv_index].d = remote_pairs[i].d; // p[i] = rec_p[q[i]]
+      nchanged += (q_loc_pairs[nontriv_index].d != remote_vals[i]);
+      q_loc_pairs[nontriv_index].d = remote_vals[i]; // p[i] = rec_p[q[i]]
     }
   
-    p.write(*loc_nontriv_num, nontriv_loc_pairs); //enter data into p[i]
+    write_local(p, *loc_nontriv_num, nontriv_loc_pairs); //enter data into p[i]
     
-    delete [] remote_pairs;
-    delete [] global_roots;
+    delete [] remote_vals;
     delete [] nontriv_loc_pairs;
     delete [] nontriv_loc_indices;
     delete loc_nontriv_num;
-  } else { // original shortcut
-    Pair<int> * remote_pairs = new Pair<int>[q_npairs];
-    for (int64_t i=0; i<q_npairs; i++) {
-      remote_pairs[i].k = q_loc_pairs[i].d;
-    }
-    Timer t_shortcut_read("CONNECTIVITY_Shortcut_read");
-    t_shortcut_read.start();
-    rec_p.read(q_npairs, remote_pairs); //obtains rec_p[q[i]]
-    t_shortcut_read.stop();
-    for (int64_t i=0; i<q_npairs; i++){
-      q_loc_pairs[i].d = remote_pairs[i].d; //p[i] = rec_p[q[i]]
-    }
-    p.write(q_npairs, q_loc_pairs); //enter data into p[i]
-
-    delete [] remote_pairs;
   }
   
   //prune out leaves
   if (create_nonleaves) {
-    *nonleaves = new Vector<int>(p.len, *p.wrld, *p.sr); //set nonleaves[i] = max_j p[j], i.e. set nonleaves[i] = 1 if i has child, i.e. is nonleaf
+    *nonleaves = new Vector<T>(p.len, *p.wrld, *p.sr); //set nonleaves[i] = max_j p[j], i.e. set nonleaves[i] = 1 if i has child, i.e. is nonleaf
     for (int64_t i=0; i<q_npairs; i++){
       q_loc_pairs[i].k = q_loc_pairs[i].d;
       q_loc_pairs[i].d = 1;
     }
-    //FIXME: here and above potential optimization is to avoid duplicate queries to parent
-    (*nonleaves)->write(q_npairs, q_loc_pairs);
+    //write each parent once
+    int64_t nparents = unique_pairs(q_npairs, q_loc_pairs);
+    (*nonleaves)->write(nparents, q_loc_pairs);
     (*nonleaves)->operator[]("i") = (*nonleaves)->operator[]("i")*p["i"];
     (*nonleaves)->sparsify();
   }
@@ -224,12 +520,14 @@ void shortcut2(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, int sc2, W
   delete [] rec_p_loc_pairs;
   delete global_roots_num;
   delete loc_roots_num;
+  return nchanged;
 }
 
-void roots_num(int64_t npairs, Pair<int> * loc_pairs, int64_t * loc_roots_num, int64_t * global_roots_num,  World * world) {
+template <typename T>
+void roots_num(int64_t npairs, Pair<T> * loc_pairs, int64_t * loc_roots_num, int64_t * global_roots_num,  World * world) {
   *loc_roots_num = 0;
   for (int64_t i = 0; i < npairs; i++) {
-    Pair<int> loc_pair = loc_pairs[i];
+    Pair<T> loc_pair = loc_pairs[i];
     if (loc_pair.d == loc_pair.k) {
       (*loc_roots_num)++;
     }
@@ -238,184 +536,1947 @@ void roots_num(int64_t npairs, Pair<int> * loc_pairs, int64_t * loc_roots_num, i
   MPI_Allreduce(loc_roots_num, global_roots_num, 1, MPI_LONG_LONG, MPI_SUM, world->comm);
 }
 
-void roots(int64_t npairs, int64_t loc_roots_num, Pair<int> * loc_pairs, int64_t * global_roots_num, int * global_roots,  World * world) {
+template <typename T>
+void roots(int64_t npairs, int64_t loc_roots_num, Pair<T> * loc_pairs, int64_t * global_roots_num, T * global_roots,  World * world) {
   int world_size;
   MPI_Comm_size(world->comm, &world_size);
  
-  int loc_roots [loc_roots_num];
+  T * loc_roots = new T[loc_roots_num];
   int64_t j = 0;
   for (int64_t i=0; i<npairs; i++) {
     // same loop as roots_num but would introduce overhead
-    Pair<int> loc_pair = loc_pairs[i];
+    Pair<T> loc_pair = loc_pairs[i];
     if (loc_pair.d == loc_pair.k) {
       loc_roots[j] = loc_pair.k;
       j++;
     }
   }
 
-  int global_roots_nums [world_size];
+  int * global_roots_nums = new int[world_size];
   MPI_Allgather(&loc_roots_num, 1, MPI_INT, global_roots_nums, 1, MPI_INT, world->comm); // [3, 1, 2, 0, 4]
 
   // prefix sum
-  int displs_roots [world_size];
+  int * displs_roots = new int[world_size];
   int64_t sum_roots = 0;
   for (int64_t i=0; i<world_size; i++) {
     displs_roots[i] = sum_roots;
     sum_roots += global_roots_nums[i];
   }
 
-  MPI_Allgatherv(loc_roots, loc_roots_num, MPI_INT, global_roots, global_roots_nums, displs_roots, MPI_INT, world->comm); // [., ., ., ., ., ., ., ., ., ., .]?
+  MPI_Allgatherv(loc_roots, loc_roots_num, mpi_type<T>(), global_roots, global_roots_nums, displs_roots, mpi_type<T>(), world->comm); // [., ., ., ., ., ., ., ., ., ., .]?
+  delete [] loc_roots;
+  delete [] global_roots_nums;
+  delete [] displs_roots;
 }
 
-void create_nontriv_loc_indices(int64_t *& nontriv_loc_indices, int64_t * loc_nontriv_num, int64_t * global_roots_num, int * global_roots, int64_t q_npairs, Pair<int> * q_loc_pairs, World * world) {
-  std::sort(global_roots, global_roots + *global_roots_num);
+// slot of key in a hash table with nslots slots, nslots a power of two
+int64_t root_slot(int64_t key, int64_t nslots) {
+  return ((uint64_t)key * 0x9E3779B97F4A7C15ULL >> 32) & (nslots - 1);
+}
 
-  nontriv_loc_indices = new int64_t[q_npairs]; // wastes a bit of memory
+// bit i of root_bits is set on every rank iff i is a root, i.e. loc_pairs[j].d == loc_pairs[j].k for the pair with key i
+template <typename T>
+void roots_bitmap(int64_t npairs, Pair<T> * loc_pairs, int64_t n, uint32_t * root_bits, World * world) {
+  int64_t nwords = (n + 31) / 32;
+  uint32_t * loc_bits = new uint32_t[nwords]();
+  for (int64_t i = 0; i < npairs; i++) {
+    if (loc_pairs[i].d == loc_pairs[i].k) {
+      loc_bits[loc_pairs[i].k / 32] |= 1u << (loc_pairs[i].k % 32);
+    }
+  }
+  MPI_Allreduce(loc_bits, root_bits, nwords, MPI_UINT32_T, MPI_BOR, world->comm);
+  delete [] loc_bits;
+}
+
+// indices of the local pairs of q whose parent is not a root
+template <typename T>
+void create_nontriv_loc_indices_bitmap(int64_t *& nontriv_loc_indices, int64_t * loc_nontriv_num, uint32_t const * root_bits, int64_t q_npairs, Pair<T> * q_loc_pairs) {
+  nontriv_loc_indices = new int64_t[q_npairs];
   int64_t nontriv_index = 0;
-  int64_t q_index = 0;
-  bool end_roots = false;
-  for (int64_t root_index = 0; root_index < *global_roots_num && q_index < q_npairs; q_index++) { // construct nontrivial local indices O((n+m)log(n+m))
-    if (q_loc_pairs[q_index].d < global_roots[root_index]) { // if a node's parent is not a root
+  for (int64_t q_index = 0; q_index < q_npairs; q_index++) {
+    int64_t parent = q_loc_pairs[q_index].d;
+    if (!((root_bits[parent / 32] >> (parent % 32)) & 1u)) {
       nontriv_loc_indices[nontriv_index] = q_index;
       nontriv_index++;
     }
-    while (q_loc_pairs[q_index].d > global_roots[root_index]) {
-      root_index++;
-      if (root_index >= *global_roots_num) { end_roots = true; break; }
-       
-      if (q_loc_pairs[q_index].d < global_roots[root_index]) { // if this node's parent is greater than previous root but less than current root
-        nontriv_loc_indices[nontriv_index] = q_index;
-        nontriv_index++;
-      }
-    }
-    if (end_roots) { break; }
+  }
+  *loc_nontriv_num = nontriv_index;
+}
+
+template <typename T>
+void create_nontriv_loc_indices(int64_t *& nontriv_loc_indices, int64_t * loc_nontriv_num, int64_t * global_roots_num, T * global_roots, int64_t q_npairs, Pair<T> * q_loc_pairs, World * world) {
+  // open-addressing hash set of the roots, so that the filter does not depend on the order of q_loc_pairs
+  int64_t nslots = 2;
+  while (nslots < 2 * *global_roots_num) nslots *= 2;
+  T * slots = new T[nslots];
+  std::fill(slots, slots + nslots, -1);
+  for (int64_t i = 0; i < *global_roots_num; i++) {
+    int64_t h = root_slot(global_roots[i], nslots);
+    while (slots[h] != -1) h = (h + 1) & (nslots - 1);
+    slots[h] = global_roots[i];
   }
 
-  for (; q_index < q_npairs; q_index++) { // add nodes with parent greater than max root
-    nontriv_loc_indices[nontriv_index] = q_index;
-    nontriv_index++;
+  nontriv_loc_indices = new int64_t[q_npairs]; // wastes a bit of memory
+  int64_t nontriv_index = 0;
+  for (int64_t q_index = 0; q_index < q_npairs; q_index++) { // O(n) expected
+    T parent = q_loc_pairs[q_index].d;
+    int64_t h = root_slot(parent, nslots);
+    while (slots[h] != -1 && slots[h] != parent) h = (h + 1) & (nslots - 1);
+    if (slots[h] == -1) { // if a node's parent is not a root
+      nontriv_loc_indices[nontriv_index] = q_index;
+      nontriv_index++;
+    }
   }
 
   *loc_nontriv_num = nontriv_index;
+  delete [] slots;
+}
+
+// sort prs by key and merge pairs with equal keys keeping the largest value, optionally dropping diagonal entries of an m-by-m matrix
+// returns the number of pairs left
+template <typename T>
+int64_t unique_pairs(int64_t nprs, Pair<T> * prs, int64_t m)
+{
+  std::sort(prs, prs + nprs, [](Pair<T> const & a, Pair<T> const & b){ return a.k < b.k; });
+  int64_t nuniq = 0;
+  for (int64_t i = 0; i < nprs; i++){
+    if (m >= 0 && prs[i].k % m == prs[i].k / m) continue;
+    if (nuniq > 0 && prs[nuniq-1].k == prs[i].k){
+      prs[nuniq-1].d = std::max(prs[nuniq-1].d, prs[i].d);
+    } else {
+      prs[nuniq++] = prs[i];
+    }
+  }
+  return nuniq;
 }
 
 // return B where B[i,j] = A[p[i],p[j]], or if P is P[i,j] = p[i], compute B = P^T A P
-Matrix<int>* PTAP(Matrix<int>* A, Vector<int>* p){
+// if m >= 0, p maps into [0, m) and B is m-by-m
+template <typename T>
+Matrix<T>* PTAP(Matrix<T>* A, Vector<T>* p, int64_t m){
   Timer t_ptap("CONNECTIVITY_PTAP");
   t_ptap.start();
   int np = p->wrld->np;
   int64_t n = p->len;
-  Pair<int> * pprs;
+  Pair<T> * pprs;
   int64_t npprs;
   //get local part of p
   p->get_local_pairs(&npprs, &pprs);
   assert((npprs <= (n+np-1)/np) && (npprs >= (n/np)));
   assert(A->ncol == n);
   assert(A->nrow == n);
-  Pair<int> * A_prs;
+  if (m < 0) m = n;
+  Pair<T> * A_prs;
   int64_t nprs;
   {
     //map matrix so rows are distributed as elements of p, ensures for each element of p, this process also owns the row of A (A1)
-    Matrix<int> A1(n, n, "ij", Partition(1,&np)["i"], Idx_Partition(), SP*(A->is_sparse), *A->wrld, *A->sr);
+    Matrix<T> A1(n, n, "ij", Partition(1,&np)["i"], Idx_Partition(), SP*(A->is_sparse), *A->wrld, *A->sr);
     A1["ij"] = A->operator[]("ij");
     A1.get_local_pairs(&nprs, &A_prs, true);
     //use fact p and rows of A are distributed cyclically, to compute P^T * A
     for (int64_t i=0; i<nprs; i++){
       A_prs[i].k = (A_prs[i].k/n)*n + pprs[(A_prs[i].k%n)/np].d;
     }
+    //edges from the same column into the same supervertex are duplicates
+    nprs = unique_pairs(nprs, A_prs);
   }
   {
     //map matrix so rows are distributed as elements of p, ensures for each element of p, this process also owns the column of A (A1)
-    Matrix<int> A2(n, n, "ij", Partition(1,&np)["j"], Idx_Partition(), SP*(A->is_sparse), *A->wrld, *A->sr);
+    Matrix<T> A2(n, n, "ij", Partition(1,&np)["j"], Idx_Partition(), SP*(A->is_sparse), *A->wrld, *A->sr);
     //write in P^T A into A2
     A2.write(nprs, A_prs);
     delete [] A_prs;
     A2.get_local_pairs(&nprs, &A_prs, true);
     //use fact p and cols of A are distributed cyclically, to compute P^T A * P
     for (int64_t i=0; i<nprs; i++){
-      A_prs[i].k = (A_prs[i].k%n) + pprs[(A_prs[i].k/n)/np].d*n;
+      A_prs[i].k = (A_prs[i].k%n) + pprs[(A_prs[i].k/n)/np].d*m;
     }
+    //drop edges inside a supervertex and parallel edges between two supervertices before writing
+    nprs = unique_pairs(nprs, A_prs, m);
+  }
+  Matrix<T> * PTAP = new Matrix<T>(m, m, SP*(A->is_sparse), *A->wrld, *A->sr);
+  PTAP->write(nprs, A_prs);
+  delete [] A_prs;
+  t_ptap.stop();
+  return PTAP;
+}
+
+// same as PTAP, but relabels the locally stored pairs of A in place and writes them into B with a single exchange of pairs
+// only the distinct endpoints of the local pairs are looked up in p, the pairs of A are not redistributed beforehand
+template <typename T>
+Matrix<T>* PTAP_direct(Matrix<T>* A, Vector<T>* p, int64_t m){
+  Timer t_ptap("CONNECTIVITY_PTAP_direct");
+  t_ptap.start();
+  int64_t n = p->len;
+  assert(A->ncol == n);
+  assert(A->nrow == n);
+  if (m < 0) m = n;
+  Pair<T> * A_prs;
+  int64_t nprs;
+  A->get_local_pairs(&nprs, &A_prs, true);
+  //distinct rows and columns of the local pairs
+  int64_t * ends = new int64_t[2*nprs];
+  for (int64_t i = 0; i < nprs; i++){
+    ends[2*i] = A_prs[i].k % n;
+    ends[2*i+1] = A_prs[i].k / n;
+  }
+  std::sort(ends, ends + 2*nprs);
+  int64_t nends = std::unique(ends, ends + 2*nprs) - ends;
+  Pair<T> * p_prs = new Pair<T>[nends];
+  for (int64_t i = 0; i < nends; i++){
+    p_prs[i].k = ends[i];
   }
-  Matrix<int> * PTAP = new Matrix<int>(n, n, SP*(A->is_sparse), *A->wrld, *A->sr);
+  p->read(nends, p_prs);
+  //B[p[i],p[j]] = A[i,j]
+  for (int64_t i = 0; i < nprs; i++){
+    int64_t row = std::lower_bound(ends, ends + nends, A_prs[i].k % n) - ends;
+    int64_t col = std::lower_bound(ends, ends + nends, A_prs[i].k / n) - ends;
+    A_prs[i].k = p_prs[row].d + p_prs[col].d*m;
+  }
+  nprs = unique_pairs(nprs, A_prs, m);
+  Matrix<T> * PTAP = new Matrix<T>(m, m, SP*(A->is_sparse), *A->wrld, *A->sr);
   PTAP->write(nprs, A_prs);
+  delete [] ends;
+  delete [] p_prs;
   delete [] A_prs;
   t_ptap.stop();
   return PTAP;
 }
 
+// ids[i] = number of keys in the distributed set smaller than pairs[i].k, returns the size of the set
+// each key is sent to the rank owning its block of [0, n), which ranks the keys it receives
+template <typename T>
+int64_t compact_keys(int64_t n, int64_t npairs, Pair<T> const * pairs, T * ids, World * world)
+{
+  Timer t_compact("CONNECTIVITY_Compact");
+  t_compact.start();
+  int np = world->np;
+  int64_t b = (n + np - 1) / np;
+  int * send_counts = new int[np]();
+  int * send_displs = new int[np];
+  int * recv_counts = new int[np];
+  int * recv_displs = new int[np];
+  for (int64_t i = 0; i < npairs; i++){
+    send_counts[pairs[i].k / b]++;
+  }
+  MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, world->comm);
+  int64_t nrecv = 0;
+  for (int i = 0; i < np; i++){
+    send_displs[i] = (i == 0) ? 0 : send_displs[i-1] + send_counts[i-1];
+    recv_displs[i] = nrecv;
+    nrecv += recv_counts[i];
+  }
+  //bucket the keys by destination, pos[i] is where the key of pairs[i] is sent from
+  T * send_keys = new T[npairs];
+  int64_t * pos = new int64_t[npairs];
+  int * fill = new int[np];
+  std::copy(send_displs, send_displs + np, fill);
+  for (int64_t i = 0; i < npairs; i++){
+    pos[i] = fill[pairs[i].k / b]++;
+    send_keys[pos[i]] = pairs[i].k;
+  }
+  T * recv_keys = new T[nrecv];
+  MPI_Alltoallv(send_keys, send_counts, send_displs, mpi_type<T>(), recv_keys, recv_counts, recv_displs, mpi_type<T>(), world->comm);
+
+  //rank the received keys within this block, offset by the number of keys in the blocks before it
+  T * sorted_keys = new T[nrecv];
+  std::copy(recv_keys, recv_keys + nrecv, sorted_keys);
+  std::sort(sorted_keys, sorted_keys + nrecv);
+  int64_t offset = 0;
+  MPI_Exscan(&nrecv, &offset, 1, MPI_LONG_LONG, MPI_SUM, world->comm);
+  if (world->rank == 0) offset = 0;
+  for (int64_t i = 0; i < nrecv; i++){
+    recv_keys[i] = offset + (std::lower_bound(sorted_keys, sorted_keys + nrecv, recv_keys[i]) - sorted_keys);
+  }
+  MPI_Alltoallv(recv_keys, recv_counts, recv_displs, mpi_type<T>(), send_keys, send_counts, send_displs, mpi_type<T>(), world->comm);
+  for (int64_t i = 0; i < npairs; i++){
+    ids[i] = send_keys[pos[i]];
+  }
+  int64_t nk;
+  MPI_Allreduce(&nrecv, &nk, 1, MPI_LONG_LONG, MPI_SUM, world->comm);
+
+  delete [] send_counts;
+  delete [] send_displs;
+  delete [] recv_counts;
+  delete [] recv_displs;
+  delete [] send_keys;
+  delete [] pos;
+  delete [] fill;
+  delete [] recv_keys;
+  delete [] sorted_keys;
+  t_compact.stop();
+  return nk;
+}
+
+// vals[i] = cidx[loc_pairs[i].d] - 1, i.e. the compact index of the label of pairs[i] or -1 if the label was not compacted
+template <typename T>
+void read_compact(Vector<T> & cidx, int64_t npairs, Pair<T> const * loc_pairs, T * vals)
+{
+  read_parents(cidx, npairs, loc_pairs, vals);
+  for (int64_t i = 0; i < npairs; i++){
+    vals[i]--;
+  }
+}
+
+template <typename T>
+Workspace<T>::Workspace(World* world) {
+  this->world = world;
+  buf = NULL;
+  buf_len = 0;
+}
+
+template <typename T>
+Workspace<T>::~Workspace() {
+  for (auto v : free_vecs) delete v;
+  delete [] buf;
+}
+
+// a dense vector of length n, reused if one was released before, its old entries are left in place
+template <typename T>
+Vector<T>* Workspace<T>::vec(int64_t n, bool sparse) {
+  if (sparse) return new Vector<T>(n, SP, *world, max_times_sr<T>());
+  for (size_t i = 0; i < free_vecs.size(); i++){
+    if (free_vecs[i]->len == n){
+      Vector<T> * v = free_vecs[i];
+      free_vecs.erase(free_vecs.begin() + i);
+      return v;
+    }
+  }
+  return new Vector<T>(n, *world, max_times_sr<T>());
+}
+
+template <typename T>
+void Workspace<T>::release(Vector<T>* v) {
+  if (v->is_sparse) delete v;
+  else free_vecs.push_back(v);
+}
+
+// scratch buffer of at least n pairs, valid until the next call
+template <typename T>
+Pair<T>* Workspace<T>::pairs(int64_t n) {
+  if (n > buf_len){
+    delete [] buf;
+    buf_len = std::max(n, 2*buf_len);
+    buf = new Pair<T>[buf_len];
+  }
+  return buf;
+}
+
+// labels of type T have to hold every vertex and the keys row + col*n of A have to fit in int64_t (n <= 3037000499),
+// aborts otherwise
+template <typename T>
+void check_label_range(int64_t n, World* world)
+{
+  if (n - 1 <= (int64_t)std::numeric_limits<T>::max() && n <= 3037000499LL) return;
+  if (world->rank == 0)
+    printf("n = %ld is too large, labels need n <= %ld and the keys of A need n <= 3037000499\n", n, (int64_t)std::numeric_limits<T>::max());
+  MPI_Abort(world->comm, 1);
+}
+
+// number of rounds until the next convergence check, from the current interval k and the average changes per round in the
+// last two intervals: it doubles up to max_k while the changes decay slowly and halves once they drop by more than half
+int next_check(int k, int max_k, int64_t rate, int64_t prev_rate)
+{
+  if (2*rate >= prev_rate) return std::min(2*k, max_k);
+  return std::max(k/2, 1);
+}
+
+// number of nonzeros of A whose endpoints have different labels in p, an upper bound on the nonzeros of PTAP(A, p)
+template <typename T>
+int64_t count_cross_edges(Matrix<T>* A, Vector<T>* p)
+{
+  int64_t n = p->len;
+  Pair<T> * A_prs;
+  int64_t nprs;
+  A->get_local_pairs(&nprs, &A_prs, true);
+  int64_t * ends = new int64_t[2*nprs];
+  for (int64_t i = 0; i < nprs; i++){
+    ends[2*i] = A_prs[i].k % n;
+    ends[2*i+1] = A_prs[i].k / n;
+  }
+  std::sort(ends, ends + 2*nprs);
+  int64_t nends = std::unique(ends, ends + 2*nprs) - ends;
+  Pair<T> * p_prs = new Pair<T>[nends];
+  for (int64_t i = 0; i < nends; i++){
+    p_prs[i].k = ends[i];
+  }
+  p->read(nends, p_prs);
+  int64_t loc_cross = 0;
+  for (int64_t i = 0; i < nprs; i++){
+    int64_t row = std::lower_bound(ends, ends + nends, A_prs[i].k % n) - ends;
+    int64_t col = std::lower_bound(ends, ends + nends, A_prs[i].k / n) - ends;
+    if (p_prs[row].d != p_prs[col].d) loc_cross++;
+  }
+  int64_t cross;
+  MPI_Allreduce(&loc_cross, &cross, 1, MPI_LONG_LONG, MPI_SUM, A->wrld->comm);
+  delete [] ends;
+  delete [] p_prs;
+  delete [] A_prs;
+  return cross;
+}
+
+// finishes a solve once few edges are left, with p a star forest and C = PTAP(A, p) the edges between its roots:
+// the edges are replicated on every rank, linked with a sequential union-find and every p[i] is replaced by the largest root of its component
+template <typename T>
+void serial_finish(Matrix<T>* C, Vector<T>* p)
+{
+  Timer t_serial("CONNECTIVITY_Serial_finish");
+  t_serial.start();
+  int64_t m = C->nrow;
+  int64_t nprs;
+  Pair<T> * prs;
+  C->get_all_pairs(&nprs, &prs, true);
+  int64_t * verts = new int64_t[2*nprs];
+  for (int64_t i = 0; i < nprs; i++){
+    verts[2*i] = prs[i].k % m;
+    verts[2*i+1] = prs[i].k / m;
+  }
+  std::sort(verts, verts + 2*nprs);
+  int64_t nv = std::unique(verts, verts + 2*nprs) - verts;
+  int64_t * parent = new int64_t[nv];
+  for (int64_t v = 0; v < nv; v++){
+    parent[v] = v;
+  }
+  for (int64_t i = 0; i < nprs; i++){
+    int64_t r = std::lower_bound(verts, verts + nv, prs[i].k % m) - verts;
+    int64_t c = std::lower_bound(verts, verts + nv, prs[i].k / m) - verts;
+    uf_union(parent, r, c);
+  }
+  delete [] prs;
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  p->read_local(&npairs, &loc_pairs);
+  for (int64_t i = 0; i < npairs; i++){
+    int64_t v = std::lower_bound(verts, verts + nv, (int64_t)loc_pairs[i].d) - verts;
+    if (v < nv && verts[v] == loc_pairs[i].d) loc_pairs[i].d = verts[uf_find(parent, v)];
+  }
+  write_local(*p, npairs, loc_pairs);
+  delete [] loc_pairs;
+  delete [] parent;
+  delete [] verts;
+  t_serial.stop();
+}
 
 //recursive projection based algorithm
-Vector<int>* supervertex_matrix(int n, Matrix<int>* A, Vector<int>* p, World* world, int sc2)
+// if handoff > 0, a level whose graph has fewer than handoff edges is solved with serial_finish instead of recursing further
+template <typename T>
+Vector<T>* supervertex_matrix(int64_t n, Matrix<T>* A, Vector<T>* p, World* world, int sc2, Workspace<T>* ws, int64_t handoff)
 {
+  if (ws == NULL){
+    //top level, owns the workspace of all recursion levels
+    check_label_range<T>(n, world);
+    Workspace<T> top_ws(world);
+    return supervertex_matrix(n, A, p, world, sc2, &top_ws, handoff);
+  }
+  if (handoff > 0 && A->is_sparse && A->nnz_tot < handoff){
+    //shortcut p to a star forest, then link the stars serially
+    JumpPlan<T> plan(p, true);
+    int64_t loc_changes, changes;
+    do {
+      loc_changes = plan.jump();
+      MPI_Allreduce(&loc_changes, &changes, 1, MPI_LONG_LONG, MPI_SUM, world->comm);
+    } while (changes > 0);
+    plan.finish();
+    auto C = PTAP_direct(A, p);
+    serial_finish(C, p);
+    delete C;
+    return p;
+  }
   Timer t_relax("CONNECTIVITY_Relaxation");
   t_relax.start();
   //relax all edges
-  auto q = new Vector<int>(n, SP*p->is_sparse, *world, MAX_TIMES_SR);
+  auto q = ws->vec(n, p->is_sparse);
   (*q)["i"] = (*p)["i"];
   (*q)["i"] += (*A)["ij"] * (*p)["j"];
   t_relax.stop();
-  Vector<int> * nonleaves;
+  Vector<T> * nonleaves;
   //check for convergence
-  int64_t diff = are_vectors_different(*q, *p);
+  int64_t diff = count_changed(*q, *p);
   if (p->wrld->rank == 0)
     printf("Diff is %ld\n",diff);
   if (!diff){
+    ws->release(q);
     return p;
   } else {
     //compute shortcutting q[i] = q[q[i]], obtain nonleaves or roots (FIXME: can we also remove roots that are by themselves?)
     shortcut2(*q, *q, *q, sc2, world, &nonleaves, true);
     if (p->wrld->rank == 0)
       printf("Number of nonleaves or roots is %ld\n",nonleaves->nnz_tot);
-    //project to reduced graph with all vertices
-    auto rec_A = PTAP(A, q);
-    //recurse only on nonleaves
-    auto rec_p = supervertex_matrix(n, rec_A, nonleaves, world, sc2);
+    //relabel the nonleaves to [0, nk) in increasing order, so the largest vertex of each component keeps the largest label
+    int64_t nl_npairs;
+    Pair<T> * nl_loc_pairs;
+    nonleaves->get_local_pairs(&nl_npairs, &nl_loc_pairs, true);
+    T * ids = new T[nl_npairs];
+    int64_t nk = compact_keys(n, nl_npairs, nl_loc_pairs, ids, world);
+    //cidx[i] = compact index of nonleaf i plus one, so that it is nonzero
+    auto cidx = new Vector<T>(n, SP, *world, max_times_sr<T>());
+    //ikey[ids[i]] = i, inverse of cidx
+    auto ikey = ws->vec(nk);
+    Pair<T> * c_pairs = ws->pairs(nl_npairs);
+    for (int64_t i = 0; i < nl_npairs; i++){
+      c_pairs[i].k = nl_loc_pairs[i].k;
+      c_pairs[i].d = ids[i] + 1;
+    }
+    cidx->write(nl_npairs, c_pairs);
+    for (int64_t i = 0; i < nl_npairs; i++){
+      c_pairs[i].k = ids[i];
+      c_pairs[i].d = nl_loc_pairs[i].k;
+    }
+    ikey->write(nl_npairs, c_pairs);
+    //rec_p0[ids[i]] = compact index of the parent of nonleaf i, which is itself a nonleaf
+    auto rec_p0 = ws->vec(nk);
+    T * vals = new T[nl_npairs];
+    read_compact(*cidx, nl_npairs, nl_loc_pairs, vals);
+    for (int64_t i = 0; i < nl_npairs; i++){
+      c_pairs[i].k = ids[i];
+      c_pairs[i].d = vals[i];
+    }
+    rec_p0->write(nl_npairs, c_pairs);
+    delete [] vals;
+    //qc[i] = compact index of q[i], -1 only for vertices without edges
+    auto qc = ws->vec(n);
+    int64_t q_npairs;
+    Pair<T> * q_loc_pairs;
+    q->get_local_pairs(&q_npairs, &q_loc_pairs);
+    vals = new T[q_npairs];
+    read_compact(*cidx, q_npairs, q_loc_pairs, vals);
+    for (int64_t i = 0; i < q_npairs; i++){
+      q_loc_pairs[i].d = vals[i];
+    }
+    qc->write(q_npairs, q_loc_pairs);
+    delete [] vals;
+    delete [] q_loc_pairs;
+    //project to reduced graph on the nonleaves only
+    auto rec_A = PTAP_direct(A, qc, nk);
+    ws->release(qc);
+    //recurse on the nk-by-nk graph
+    auto rec_p = supervertex_matrix(nk, rec_A, rec_p0, world, sc2, ws, handoff);
     delete rec_A;
+    //unpack, rec_full[i] = ikey[rec_p[ids[i]]] for nonleaves i
+    shortcut(*rec_p, *rec_p, *ikey);
+    Pair<T> * rec_pairs = ws->pairs(nl_npairs);
+    for (int64_t i = 0; i < nl_npairs; i++){
+      rec_pairs[i].k = ids[i];
+    }
+    rec_p->read(nl_npairs, rec_pairs);
+    for (int64_t i = 0; i < nl_npairs; i++){
+      nl_loc_pairs[i].d = rec_pairs[i].d;
+    }
+    auto rec_full = new Vector<T>(n, SP, *world, max_times_sr<T>());
+    rec_full->write(nl_npairs, nl_loc_pairs);
+    delete [] nl_loc_pairs;
+    delete [] ids;
+    delete cidx;
+    ws->release(ikey);
+    ws->release(rec_p);
+    delete nonleaves;
     //perform one step of shortcutting to update components of leaves
-    shortcut2(*p, *q, *rec_p, sc2, world);
-    delete q;
-    delete rec_p;
+    shortcut2(*p, *q, *rec_full, sc2, world);
+    ws->release(q);
+    delete rec_full;
     return p;
   }
 }
 
-Vector<int>* hook_matrix(int n, Matrix<int> * A, World* world)
-{
-  auto p = new Vector<int>(n, *world, MAX_TIMES_SR);
-  init_pvector(p);
-  auto prev = new Vector<int>(n, *world, MAX_TIMES_SR);
+template <typename T>
+JumpPlan<T>::JumpPlan(Vector<T>* p, bool multihop, int cyclic) {
+  this->p = p;
+  this->multihop = multihop;
+  int np = p->wrld->np;
+  int rank = p->wrld->rank;
+  p->read_local(&nloc, &loc_pairs);
+  //the plan indexes local entries by key / np, which requires the cyclic layout
+  if (cyclic < 0){
+    int loc_aligned = 1;
+    for (int64_t i = 0; loc_aligned && i < nloc; i++){
+      loc_aligned = (loc_pairs[i].k == rank + i*np);
+    }
+    MPI_Allreduce(&loc_aligned, &cyclic, 1, MPI_INT, MPI_LAND, p->wrld->comm);
+  }
+  aligned = cyclic;
+  nactive = nloc;
+  active = new int64_t[nloc];
+  changed = new bool[nloc];
+  for (int64_t i = 0; i < nloc; i++){
+    active[i] = i;
+    changed[i] = false;
+  }
+  send_counts = new int[np];
+  send_displs = new int[np];
+  recv_counts = new int[np];
+  recv_displs = new int[np];
+  keys = new T[nloc];
+  serve = new T[nloc];
+}
 
-  while (are_vectors_different(*p, *prev)) {
-    (*prev)["i"] = (*p)["i"];
-    auto q = new Vector<int>(n, *world, MAX_TIMES_SR);
-    Timer t_relax("CONNECTIVITY_Relaxation");
-    t_relax.start();
-    (*q)["i"] = (*A)["ij"] * (*p)["j"];
-    t_relax.stop();
-    auto r = new Vector<int>(n, *world, MAX_TIMES_SR);
-    max_vector(*r, *p, *q);
-    //auto P = pMatrix(p, world);
-    auto s = new Vector<int>(n, *world, MAX_TIMES_SR);
-    //(*s)["i"] = (*P)["ji"] * (*r)["j"];
-    shortcut(*s, *r, *p);
-    max_vector(*p, *p, *s);
-    Vector<int> * pi = new Vector<int>(*p);
-    shortcut(*p, *p, *p);
+template <typename T>
+JumpPlan<T>::~JumpPlan() {
+  delete [] loc_pairs;
+  delete [] active;
+  delete [] changed;
+  delete [] send_counts;
+  delete [] send_displs;
+  delete [] recv_counts;
+  delete [] recv_displs;
+  delete [] keys;
+  delete [] serve;
+}
+
+// follows the parents of c through local entries and cached remote ones,
+// returns the last vertex reached and sets *root if it is known to be a root
+template <typename T>
+T JumpPlan<T>::resolve(T c, bool * root) {
+  int np = p->wrld->np;
+  int rank = p->wrld->rank;
+  while (true) {
+    T next;
+    if (c % np == rank) {
+      next = loc_pairs[c / np].d;
+    } else {
+      auto it = cache.find(c);
+      if (it == cache.end()) {
+        *root = false;
+        return c;
+      }
+      next = it->second;
+    }
+    if (next == c) {
+      *root = true;
+      return c;
+    }
+    c = next;
+  }
+}
+
+// sends the distinct keys[0, nkeys) to their owners and returns how many there are,
+// afterwards keys are grouped by owner with send_displs/send_counts and vals[i] is the answer for keys[i]
+template <typename T>
+int64_t JumpPlan<T>::exchange(int64_t nkeys, T *& vals) {
+  int np = p->wrld->np;
+  std::sort(keys, keys + nkeys, [np](T a, T b){ return a % np < b % np || (a % np == b % np && a < b); });
+  nkeys = std::unique(keys, keys + nkeys) - keys;
+  std::fill(send_counts, send_counts + np, 0);
+  for (int64_t i = 0; i < nkeys; i++){
+    send_counts[keys[i] % np]++;
+  }
+  MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, p->wrld->comm);
+  int64_t nserve = 0;
+  for (int i = 0; i < np; i++){
+    send_displs[i] = (i == 0) ? 0 : send_displs[i-1] + send_counts[i-1];
+    recv_displs[i] = nserve;
+    nserve += recv_counts[i];
+  }
+  T * serve_buf = nserve > nloc ? new T[nserve] : serve;
+  MPI_Alltoallv(keys, send_counts, send_displs, mpi_type<T>(), serve_buf, recv_counts, recv_displs, mpi_type<T>(), p->wrld->comm);
+  //owners answer with their current label, or in multihop mode with the furthest ancestor they can reach locally
+  for (int64_t i = 0; i < nserve; i++){
+    if (multihop) {
+      bool root;
+      serve_buf[i] = resolve(loc_pairs[serve_buf[i] / np].d, &root);
+    } else {
+      serve_buf[i] = loc_pairs[serve_buf[i] / np].d;
+    }
+  }
+  vals = new T[nkeys];
+  MPI_Alltoallv(serve_buf, recv_counts, recv_displs, mpi_type<T>(), vals, send_counts, send_displs, mpi_type<T>(), p->wrld->comm);
+  if (serve_buf != serve) delete [] serve_buf;
+  return nkeys;
+}
 
-    while (are_vectors_different(*pi, *p)){
-      delete pi;
-      pi = new Vector<int>(*p);
-      shortcut(*p, *p, *p);
+// one round of p[i] = p[p[i]] over the active vertices, returns the local number of entries that changed
+// in multihop mode, every vertex first climbs as far as local and cached entries allow, and the answers of the round are cached
+template <typename T>
+int64_t JumpPlan<T>::jump() {
+  if (!aligned) return shortcut(*p, *p, *p);
+  Timer t_jump("CONNECTIVITY_Jump");
+  t_jump.start();
+  int np = p->wrld->np;
+  int64_t nchanged = 0;
+  int64_t nkeys = 0;
+  T * vals;
+  if (multihop) {
+    int64_t nstill = 0;
+    for (int64_t i = 0; i < nactive; i++){
+      int64_t j = active[i];
+      bool root;
+      T r = resolve(loc_pairs[j].d, &root);
+      if (r != loc_pairs[j].d){
+        loc_pairs[j].d = r;
+        changed[j] = true;
+        nchanged++;
+      }
+      if (!root){
+        active[nstill++] = j;
+        keys[nkeys++] = r;
+      }
+    }
+    nactive = nstill;
+    nkeys = exchange(nkeys, vals);
+    for (int64_t i = 0; i < nkeys; i++){
+      cache[keys[i]] = vals[i];
+    }
+  } else {
+    for (int64_t i = 0; i < nactive; i++){
+      keys[nkeys++] = loc_pairs[active[i]].d;
+    }
+    nkeys = exchange(nkeys, vals);
+  }
+  //all active vertices jump at once
+  int64_t nstill = 0;
+  for (int64_t i = 0; i < nactive; i++){
+    int64_t j = active[i];
+    T par = loc_pairs[j].d;
+    T gp;
+    bool root;
+    if (multihop) {
+      gp = resolve(par, &root);
+    } else {
+      T * pos = std::lower_bound(keys + send_displs[par % np], keys + send_displs[par % np] + send_counts[par % np], par);
+      gp = vals[pos - keys];
+      root = (gp == par);
     }
-    delete pi;
+    if (gp != par){
+      loc_pairs[j].d = gp;
+      changed[j] = true;
+      nchanged++;
+    }
+    if (!root){
+      //the parent was not known to be a root, so i may move again
+      active[nstill++] = j;
+    }
+  }
+  nactive = nstill;
+  delete [] vals;
+  t_jump.stop();
+  return nchanged;
+}
 
-    delete q;
-    delete r;
-    delete s;
+// write the entries that changed back into p
+template <typename T>
+void JumpPlan<T>::finish() {
+  if (!aligned) return;
+  int64_t nchanged = 0;
+  for (int64_t i = 0; i < nloc; i++){
+    if (changed[i]) loc_pairs[nchanged++] = loc_pairs[i];
   }
-  return p;
+  write_local(*p, nchanged, loc_pairs, 1);
 }
 
+// max(m, vals[idx[0]], ..., vals[idx[len-1]])
+template <typename T>
+inline T gather_max(T m, T const * vals, T const * idx, int64_t len)
+{
+  for (int64_t e = 0; e < len; e++){
+    m = std::max(m, vals[idx[e]]);
+  }
+  return m;
+}
+
+// int labels use gathers and vector max with AVX-512 or AVX2 when compiled for them, the remainder is scalar
+template <>
+inline int gather_max<int>(int m, int const * vals, int const * idx, int64_t len)
+{
+  int64_t e = 0;
+#if defined(__AVX512F__)
+  __m512i vm = _mm512_set1_epi32(m);
+  for (; e + 16 <= len; e += 16){
+    __m512i vi = _mm512_loadu_si512((void const *)(idx + e));
+    vm = _mm512_max_epi32(vm, _mm512_i32gather_epi32(vi, vals, 4));
+  }
+  m = _mm512_reduce_max_epi32(vm);
+#elif defined(__AVX2__)
+  __m256i vm = _mm256_set1_epi32(m);
+  for (; e + 8 <= len; e += 8){
+    __m256i vi = _mm256_loadu_si256((__m256i const *)(idx + e));
+    vm = _mm256_max_epi32(vm, _mm256_i32gather_epi32(vals, vi, 4));
+  }
+  int lanes[8];
+  _mm256_storeu_si256((__m256i *)lanes, vm);
+  for (int l = 0; l < 8; l++){
+    m = std::max(m, lanes[l]);
+  }
+#endif
+  for (; e < len; e++){
+    m = std::max(m, vals[idx[e]]);
+  }
+  return m;
+}
+
+template <typename T>
+PatternCSR<T>::PatternCSR(Matrix<T>* A, int64_t hub_deg) {
+  Timer t_build("CONNECTIVITY_Pattern_build");
+  t_build.start();
+  this->A = A;
+  n = A->nrow;
+  World * world = A->wrld;
+  int np = world->np;
+  int rank = world->rank;
+  nrows = (n - rank + np - 1) / np;
+  //send every nonzero to the owner of its row
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  A->get_local_pairs(&npairs, &loc_pairs, true);
+  int * send_counts = new int[np]();
+  int * send_displs = new int[np];
+  int * recv_counts = new int[np];
+  int * recv_displs = new int[np];
+  for (int64_t i = 0; i < npairs; i++){
+    send_counts[(loc_pairs[i].k % n) % np]++;
+  }
+  MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, world->comm);
+  int64_t nrecv = 0;
+  for (int i = 0; i < np; i++){
+    send_displs[i] = (i == 0) ? 0 : send_displs[i-1] + send_counts[i-1];
+    recv_displs[i] = nrecv;
+    nrecv += recv_counts[i];
+  }
+  int64_t * send_keys = new int64_t[npairs];
+  int * fill = new int[np];
+  std::copy(send_displs, send_displs + np, fill);
+  for (int64_t i = 0; i < npairs; i++){
+    send_keys[fill[(loc_pairs[i].k % n) % np]++] = loc_pairs[i].k;
+  }
+  delete [] loc_pairs;
+  int64_t * keys = new int64_t[nrecv];
+  MPI_Alltoallv(send_keys, send_counts, send_displs, MPI_INT64_T, keys, recv_counts, recv_displs, MPI_INT64_T, world->comm);
+  delete [] send_keys;
+  delete [] fill;
+
+  //rows with at least hub_deg nonzeros are hubs, their labels are replicated on all ranks and their nonzeros dealt out in blocks
+  nhubs = 0;
+  hubs = NULL;
+  int64_t nkeys = nrecv;
+  int64_t nhkeys = 0;
+  int64_t * hkeys = NULL;
+  if (hub_deg > 0){
+    int64_t * deg = new int64_t[nrows]();
+    for (int64_t i = 0; i < nrecv; i++){
+      deg[(keys[i] % n) / np]++;
+    }
+    std::vector<T> loc_hubs;
+    for (int64_t i = 0; i < nrows; i++){
+      if (deg[i] >= hub_deg) loc_hubs.push_back(rank + i*np);
+    }
+    int nloc_hubs = loc_hubs.size();
+    MPI_Allgather(&nloc_hubs, 1, MPI_INT, recv_counts, 1, MPI_INT, world->comm);
+    for (int i = 0; i < np; i++){
+      recv_displs[i] = nhubs;
+      nhubs += recv_counts[i];
+    }
+    hubs = new T[nhubs];
+    MPI_Allgatherv(loc_hubs.data(), nloc_hubs, mpi_type<T>(), hubs, recv_counts, recv_displs, mpi_type<T>(), world->comm);
+    std::sort(hubs, hubs + nhubs);
+    nkeys = std::partition(keys, keys + nrecv, [&](int64_t k){ return deg[(k % n) / np] < hub_deg; }) - keys;
+    delete [] deg;
+    int64_t nh = nrecv - nkeys;
+    for (int i = 0; i < np; i++){
+      send_counts[i] = nh*(i+1)/np - nh*i/np;
+      send_displs[i] = nh*i/np;
+    }
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, world->comm);
+    for (int i = 0; i < np; i++){
+      recv_displs[i] = nhkeys;
+      nhkeys += recv_counts[i];
+    }
+    hkeys = new int64_t[nhkeys];
+    MPI_Alltoallv(keys + nkeys, send_counts, send_displs, MPI_INT64_T, hkeys, recv_counts, recv_displs, MPI_INT64_T, world->comm);
+  }
+  delete [] send_counts;
+  delete [] send_displs;
+  delete [] recv_counts;
+  delete [] recv_displs;
+
+  //distinct non-hub columns grouped by owner
+  auto owner_less = [np](T a, T b){ return a % np < b % np || (a % np == b % np && a < b); };
+  ghosts = new T[nkeys + nhkeys];
+  nghosts = 0;
+  for (int64_t i = 0; i < nkeys + nhkeys; i++){
+    T col = (i < nkeys ? keys[i] : hkeys[i - nkeys]) / n;
+    if (!std::binary_search(hubs, hubs + nhubs, col)) ghosts[nghosts++] = col;
+  }
+  std::sort(ghosts, ghosts + nghosts, owner_less);
+  nghosts = std::unique(ghosts, ghosts + nghosts) - ghosts;
+  //columns index the ghost labels followed by the hub labels
+  auto col_of = [&](int64_t k){
+    T col = k / n;
+    T * h = std::lower_bound(hubs, hubs + nhubs, col);
+    if (h != hubs + nhubs && *h == col) return (T)(nghosts + (h - hubs));
+    return (T)(std::lower_bound(ghosts, ghosts + nghosts, col, owner_less) - ghosts);
+  };
+
+  //CSR over the local rows
+  row_ptr = new int64_t[nrows + 1]();
+  for (int64_t i = 0; i < nkeys; i++){
+    row_ptr[(keys[i] % n) / np + 1]++;
+  }
+  for (int64_t i = 0; i < nrows; i++){
+    row_ptr[i + 1] += row_ptr[i];
+  }
+  col_idx = new T[nkeys];
+  int64_t * pos = new int64_t[nrows];
+  std::copy(row_ptr, row_ptr + nrows, pos);
+  for (int64_t i = 0; i < nkeys; i++){
+    col_idx[pos[(keys[i] % n) / np]++] = col_of(keys[i]);
+  }
+  delete [] pos;
+  delete [] keys;
+
+  //CSR over the block of hub nonzeros held here
+  hub_ptr = new int64_t[nhubs + 1]();
+  for (int64_t i = 0; i < nhkeys; i++){
+    hub_ptr[std::lower_bound(hubs, hubs + nhubs, (T)(hkeys[i] % n)) - hubs + 1]++;
+  }
+  for (int64_t i = 0; i < nhubs; i++){
+    hub_ptr[i + 1] += hub_ptr[i];
+  }
+  hub_idx = new T[nhkeys];
+  pos = new int64_t[nhubs];
+  std::copy(hub_ptr, hub_ptr + nhubs, pos);
+  for (int64_t i = 0; i < nhkeys; i++){
+    hub_idx[pos[std::lower_bound(hubs, hubs + nhubs, (T)(hkeys[i] % n)) - hubs]++] = col_of(hkeys[i]);
+  }
+  delete [] pos;
+  delete [] hkeys;
+
+  //exchange plan, each ghost label is requested from the owner of its column
+  req_counts = new int[np]();
+  req_displs = new int[np];
+  srv_counts = new int[np];
+  srv_displs = new int[np];
+  for (int64_t i = 0; i < nghosts; i++){
+    req_counts[ghosts[i] % np]++;
+  }
+  MPI_Alltoall(req_counts, 1, MPI_INT, srv_counts, 1, MPI_INT, world->comm);
+  nserve = 0;
+  for (int i = 0; i < np; i++){
+    req_displs[i] = (i == 0) ? 0 : req_displs[i-1] + req_counts[i-1];
+    srv_displs[i] = nserve;
+    nserve += srv_counts[i];
+  }
+  T * srv_keys = new T[nserve];
+  MPI_Alltoallv(ghosts, req_counts, req_displs, mpi_type<T>(), srv_keys, srv_counts, srv_displs, mpi_type<T>(), world->comm);
+  serve = new int64_t[nserve];
+  for (int64_t i = 0; i < nserve; i++){
+    serve[i] = srv_keys[i] / np;
+  }
+  delete [] srv_keys;
+  t_build.stop();
+}
+
+template <typename T>
+PatternCSR<T>::~PatternCSR() {
+  delete [] row_ptr;
+  delete [] col_idx;
+  delete [] ghosts;
+  delete [] req_counts;
+  delete [] req_displs;
+  delete [] srv_counts;
+  delete [] srv_displs;
+  delete [] serve;
+  delete [] hubs;
+  delete [] hub_ptr;
+  delete [] hub_idx;
+}
+
+// r[i] = max(p[i], max_j A[i,j] * p[j]) over the pattern, p has to be dense and cyclic, otherwise falls back to a contraction with A,
+// r has to be distributed like p
+template <typename T>
+void PatternCSR<T>::relax(Vector<T>& p, Vector<T>& r) {
+  Timer t_relax("CONNECTIVITY_Pattern_relax");
+  t_relax.start();
+  World * world = p.wrld;
+  int np = world->np;
+  int rank = world->rank;
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  p.read_local(&npairs, &loc_pairs);
+  int loc_aligned = !p.is_sparse && npairs == nrows;
+  for (int64_t i = 0; loc_aligned && i < npairs; i++){
+    loc_aligned = (loc_pairs[i].k == rank + i*np);
+  }
+  int aligned;
+  MPI_Allreduce(&loc_aligned, &aligned, 1, MPI_INT, MPI_LAND, world->comm);
+  if (!aligned){
+    delete [] loc_pairs;
+    Vector<T> q(n, *world, max_times_sr<T>());
+    q["i"] = (*A)["ij"] * p["j"];
+    max_vector(r, p, q);
+    t_relax.stop();
+    return;
+  }
+  T * srv_vals = new T[nserve];
+  for (int64_t i = 0; i < nserve; i++){
+    srv_vals[i] = loc_pairs[serve[i]].d;
+  }
+  T * ghost_vals = new T[nghosts + nhubs];
+  MPI_Alltoallv(srv_vals, srv_counts, srv_displs, mpi_type<T>(), ghost_vals, req_counts, req_displs, mpi_type<T>(), world->comm);
+  delete [] srv_vals;
+  //hub labels come from their owners through one allreduce
+  T * hub_vals = new T[nhubs];
+  for (int64_t h = 0; h < nhubs; h++){
+    hub_vals[h] = (hubs[h] % np == rank) ? loc_pairs[hubs[h] / np].d : 0;
+  }
+  if (nhubs > 0){
+    MPI_Allreduce(hub_vals, ghost_vals + nghosts, nhubs, mpi_type<T>(), MPI_MAX, world->comm);
+  }
+  #pragma omp parallel for
+  for (int64_t i = 0; i < nrows; i++){
+    loc_pairs[i].d = gather_max(loc_pairs[i].d, ghost_vals, col_idx + row_ptr[i], row_ptr[i + 1] - row_ptr[i]);
+  }
+  //hub rows are relaxed in parts on every rank and combined with another allreduce
+  if (nhubs > 0){
+    for (int64_t h = 0; h < nhubs; h++){
+      hub_vals[h] = gather_max((T)0, ghost_vals, hub_idx + hub_ptr[h], hub_ptr[h + 1] - hub_ptr[h]);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, hub_vals, nhubs, mpi_type<T>(), MPI_MAX, world->comm);
+    for (int64_t h = 0; h < nhubs; h++){
+      if (hubs[h] % np == rank) loc_pairs[hubs[h] / np].d = std::max(loc_pairs[hubs[h] / np].d, hub_vals[h]);
+    }
+  }
+  delete [] hub_vals;
+  write_local(r, npairs, loc_pairs, 1);
+  delete [] ghost_vals;
+  delete [] loc_pairs;
+  t_relax.stop();
+}
+
+template <typename T>
+PatternGrid<T>::PatternGrid(Matrix<T>* A) {
+  Timer t_build("CONNECTIVITY_Grid_build");
+  t_build.start();
+  this->A = A;
+  n = A->nrow;
+  World * world = A->wrld;
+  int np = world->np;
+  int rank = world->rank;
+  //closest to square grid with pr <= pc
+  pr = (int)sqrt((double)np);
+  while (np % pr != 0) pr--;
+  pc = np / pr;
+  int grow = rank / pc;
+  int gcol = rank % pc;
+  MPI_Comm_split(world->comm, grow, gcol, &row_comm);
+  MPI_Comm_split(world->comm, gcol, grow, &col_comm);
+  //the local rows are the pieces of p owned by this grid row, ordered by grid column, the local columns likewise for this grid column
+  row_counts = new int[pc];
+  int * row_displs = new int[pc];
+  nrows = 0;
+  for (int b = 0; b < pc; b++){
+    int owner = grow*pc + b;
+    row_counts[b] = (n - owner + np - 1) / np;
+    row_displs[b] = nrows;
+    nrows += row_counts[b];
+  }
+  col_counts = new int[pr];
+  col_displs = new int[pr];
+  ncols = 0;
+  for (int a = 0; a < pr; a++){
+    int owner = a*pc + gcol;
+    col_counts[a] = (n - owner + np - 1) / np;
+    col_displs[a] = ncols;
+    ncols += col_counts[a];
+  }
+
+  //send every nonzero to the grid row of its row and the grid column of its column
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  A->get_local_pairs(&npairs, &loc_pairs, true);
+  int * send_counts = new int[np]();
+  int * send_displs = new int[np];
+  int * recv_counts = new int[np];
+  int * recv_displs = new int[np];
+  auto dest = [&](int64_t k){ return (int)(((k % n) % np) / pc * pc + ((k / n) % np) % pc); };
+  for (int64_t i = 0; i < npairs; i++){
+    send_counts[dest(loc_pairs[i].k)]++;
+  }
+  MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, world->comm);
+  int64_t nrecv = 0;
+  for (int i = 0; i < np; i++){
+    send_displs[i] = (i == 0) ? 0 : send_displs[i-1] + send_counts[i-1];
+    recv_displs[i] = nrecv;
+    nrecv += recv_counts[i];
+  }
+  int64_t * send_keys = new int64_t[npairs];
+  int * fill = new int[np];
+  std::copy(send_displs, send_displs + np, fill);
+  for (int64_t i = 0; i < npairs; i++){
+    send_keys[fill[dest(loc_pairs[i].k)]++] = loc_pairs[i].k;
+  }
+  delete [] loc_pairs;
+  int64_t * keys = new int64_t[nrecv];
+  MPI_Alltoallv(send_keys, send_counts, send_displs, MPI_INT64_T, keys, recv_counts, recv_displs, MPI_INT64_T, world->comm);
+  delete [] send_keys;
+  delete [] send_counts;
+  delete [] send_displs;
+  delete [] recv_counts;
+  delete [] recv_displs;
+  delete [] fill;
+
+  //CSR over the local rows, with columns as offsets into the expanded column labels
+  auto lrow = [&](int64_t i){ return row_displs[(i % np) % pc] + i / np; };
+  row_ptr = new int64_t[nrows + 1]();
+  for (int64_t i = 0; i < nrecv; i++){
+    row_ptr[lrow(keys[i] % n) + 1]++;
+  }
+  for (int64_t i = 0; i < nrows; i++){
+    row_ptr[i + 1] += row_ptr[i];
+  }
+  col_idx = new T[nrecv];
+  int64_t * pos = new int64_t[nrows];
+  std::copy(row_ptr, row_ptr + nrows, pos);
+  for (int64_t i = 0; i < nrecv; i++){
+    int64_t j = keys[i] / n;
+    col_idx[pos[lrow(keys[i] % n)]++] = col_displs[(j % np) / pc] + j / np;
+  }
+  delete [] pos;
+  delete [] keys;
+  delete [] row_displs;
+  t_build.stop();
+}
+
+template <typename T>
+PatternGrid<T>::~PatternGrid() {
+  MPI_Comm_free(&row_comm);
+  MPI_Comm_free(&col_comm);
+  delete [] row_ptr;
+  delete [] col_idx;
+  delete [] row_counts;
+  delete [] col_counts;
+  delete [] col_displs;
+}
+
+// r[i] = max(p[i], max_j A[i,j] * p[j]) over the pattern, p has to be dense and cyclic, otherwise falls back to a contraction with A,
+// r has to be distributed like p
+template <typename T>
+void PatternGrid<T>::relax(Vector<T>& p, Vector<T>& r) {
+  Timer t_relax("CONNECTIVITY_Grid_relax");
+  t_relax.start();
+  World * world = p.wrld;
+  int np = world->np;
+  int rank = world->rank;
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  p.read_local(&npairs, &loc_pairs);
+  int loc_aligned = !p.is_sparse && npairs == (n - rank + np - 1) / np;
+  for (int64_t i = 0; loc_aligned && i < npairs; i++){
+    loc_aligned = (loc_pairs[i].k == rank + i*np);
+  }
+  int aligned;
+  MPI_Allreduce(&loc_aligned, &aligned, 1, MPI_INT, MPI_LAND, world->comm);
+  if (!aligned){
+    delete [] loc_pairs;
+    Vector<T> q(n, *world, max_times_sr<T>());
+    q["i"] = (*A)["ij"] * p["j"];
+    max_vector(r, p, q);
+    t_relax.stop();
+    return;
+  }
+  T * loc_vals = new T[npairs];
+  for (int64_t i = 0; i < npairs; i++){
+    loc_vals[i] = loc_pairs[i].d;
+  }
+  //expand
+  T * col_vals = new T[ncols];
+  MPI_Allgatherv(loc_vals, npairs, mpi_type<T>(), col_vals, col_counts, col_displs, mpi_type<T>(), col_comm);
+  T * row_vals = new T[nrows];
+  #pragma omp parallel for
+  for (int64_t i = 0; i < nrows; i++){
+    row_vals[i] = gather_max((T)0, col_vals, col_idx + row_ptr[i], row_ptr[i + 1] - row_ptr[i]);
+  }
+  delete [] col_vals;
+  //fold
+  MPI_Reduce_scatter(row_vals, loc_vals, row_counts, mpi_type<T>(), MPI_MAX, row_comm);
+  delete [] row_vals;
+  for (int64_t i = 0; i < npairs; i++){
+    loc_pairs[i].d = std::max(loc_pairs[i].d, loc_vals[i]);
+  }
+  write_local(r, npairs, loc_pairs, 1);
+  delete [] loc_vals;
+  delete [] loc_pairs;
+  t_relax.stop();
+}
+
+// sparse vector with the entries of p that differ from the earlier local pairs prev_pairs of p
+template <typename T>
+Vector<T>* changed_vector(Vector<T> & p, int64_t npairs, Pair<T> * prev_pairs)
+{
+  T * vals = new T[npairs];
+  read_aligned(p, npairs, prev_pairs, vals);
+  int64_t nchanged = 0;
+  for (int64_t i = 0; i < npairs; i++){
+    if (prev_pairs[i].d != vals[i]){
+      prev_pairs[nchanged].k = prev_pairs[i].k;
+      prev_pairs[nchanged].d = vals[i];
+      nchanged++;
+    }
+  }
+  auto changed = new Vector<T>(p.len, SP, *p.wrld, max_times_sr<T>());
+  changed->write(nchanged, prev_pairs);
+  delete [] vals;
+  return changed;
+}
+
+// if frontier_frac > 0, q = A * p is kept across iterations and relaxed only from the vertices whose label changed
+// in the last iteration, as long as there are fewer than frontier_frac * n of them
+// if pattern = 1, the relaxation runs over a value-free local CSR copy of A instead, if pattern = 2 over a 2D grid layout of A
+// (frontier_frac is ignored for both), with pattern = 1 and hub_deg > 0 the labels of rows with at least hub_deg nonzeros are replicated
+// if handoff > 0, once fewer than handoff labels change in an iteration and fewer than handoff edges are left between the stars
+// (tested with count_cross_edges, backing off exponentially after a failed test),
+// the solve is finished with serial_finish
+// if max_check > 1, the shortcutting checks for a stable p only every k jumps, with k adapted between 1 and max_check by next_check
+// and kept across iterations
+template <typename T>
+Vector<T>* hook_matrix(int64_t n, Matrix<T> * A, World* world, double frontier_frac, int pattern, int64_t hub_deg, int64_t handoff, int max_check)
+{
+  check_label_range<T>(n, world);
+  auto p = new Vector<T>(n, *world, max_times_sr<T>());
+  init_pvector(p);
+  Workspace<T> ws(world);
+  auto q = ws.vec(n);
+  PatternCSR<T> * csr = NULL;
+  PatternGrid<T> * grid = NULL;
+  if (pattern == 1) {
+    csr = new PatternCSR<T>(A, hub_deg);
+    frontier_frac = 0.;
+  } else if (pattern == 2) {
+    grid = new PatternGrid<T>(A);
+    frontier_frac = 0.;
+  }
+  Vector<T> * changed = NULL;
+  int64_t nchanged = n;
+  int handoff_backoff = 1;
+  int handoff_wait = 1;
+  int p_cyclic = -1;
+  //the interval between stability checks of the shortcutting and its rate of change carry over between iterations,
+  //since each shortcutting loop only takes a few rounds
+  int k = 1;
+  int64_t prev_rate = n;
+  int64_t nprev;
+  Pair<T> * prev_pairs = NULL;
+
+  while (true) {
+    if (frontier_frac > 0.) {
+      delete [] prev_pairs;
+      p->read_local(&nprev, &prev_pairs);
+    }
+    auto r = ws.vec(n);
+    Timer t_relax("CONNECTIVITY_Relaxation");
+    t_relax.start();
+    if (csr != NULL) {
+      csr->relax(*p, *r);
+    } else if (grid != NULL) {
+      grid->relax(*p, *r);
+    } else {
+      if (changed != NULL && nchanged < frontier_frac * n) {
+        //labels only grow, so max(q, A * p[changed]) = A * p
+        (*q)["i"] += (*A)["ij"] * (*changed)["j"];
+      } else {
+        (*q)["i"] = (*A)["ij"] * (*p)["j"];
+      }
+      max_vector(*r, *p, *q);
+    }
+    t_relax.stop();
+    //contractions may remap p, the pattern relaxations never do
+    if (p_cyclic < 0 || (csr == NULL && grid == NULL)) p_cyclic = cyclic_layout(*p);
+    //auto P = pMatrix(p, world);
+    auto s = ws.vec(n);
+    //(*s)["i"] = (*P)["ji"] * (*r)["j"];
+    shortcut(*s, *r, *p);
+    //p is a star forest at the start of every iteration, so nothing changes in this iteration if the hooking changes nothing
+    int64_t loc_changes[3] = {0, max_update(*p, *s, p_cyclic), 0};
+    int64_t changes[3];
+    //shortcut until p is stable, the number of changes in this iteration is reduced together with the number in each round,
+    //the third count sums the rounds since the last check, jumps past a stable p change nothing
+    JumpPlan<T> plan(p, true, p_cyclic);
+    int rounds = 0;
+    while (true) {
+      loc_changes[0] = plan.jump();
+      loc_changes[1] += loc_changes[0];
+      loc_changes[2] += loc_changes[0];
+      if (++rounds < k) continue;
+      MPI_Allreduce(loc_changes, changes, 3, MPI_LONG_LONG, MPI_SUM, world->comm);
+      if (changes[0] == 0) break;
+      int64_t rate = changes[2] / rounds;
+      k = next_check(k, max_check, rate, prev_rate);
+      prev_rate = rate;
+      rounds = 0;
+      loc_changes[2] = 0;
+    }
+    plan.finish();
+
+    ws.release(r);
+    ws.release(s);
+    if (changes[1] == 0) break;
+    if (handoff > 0 && changes[1] < handoff && --handoff_wait <= 0) {
+      //the edges between different stars are the ones still to be resolved, they are only contracted once few are left,
+      //otherwise the next test waits twice as many iterations
+      if (count_cross_edges(A, p) < handoff) {
+        auto C = PTAP_direct(A, p);
+        serial_finish(C, p);
+        delete C;
+        break;
+      }
+      handoff_backoff *= 2;
+      handoff_wait = handoff_backoff;
+    }
+    if (frontier_frac > 0.) {
+      //the number of changes bounds the number of changed vertices from above
+      nchanged = changes[1];
+      delete changed;
+      changed = changed_vector(*p, nprev, prev_pairs);
+    }
+  }
+  delete changed;
+  delete [] prev_pairs;
+  delete csr;
+  delete grid;
+  ws.release(q);
+  return p;
+}
+
+template int cyclic_layout<int>(Vector<int> & v, int64_t npairs, Pair<int> const * pairs);
+template void write_local<int>(Vector<int> & p, int64_t npairs, Pair<int> const * pairs, int cyclic);
+template void init_pvector<int>(Vector<int>* p);
+template void read_aligned<int>(Vector<int> & v, int64_t npairs, Pair<int> const * loc_pairs, int * vals);
+template Matrix<int>* pMatrix<int>(Vector<int>* p, World* world);
+template void read_parents<int>(Vector<int> & rec_p, int64_t npairs, Pair<int> const * loc_pairs, int * vals);
+template int64_t max_update<int>(Vector<int> & p, Vector<int> & s, int cyclic);
+template int64_t count_changed<int>(Vector<int> & q, Vector<int> & p);
+template int64_t shortcut<int>(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, Vector<int> ** nonleaves, bool create_nonleaves);
+template int64_t shortcut_pipelined<int>(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, int nchunks, Vector<int> ** nonleaves, bool create_nonleaves);
+template int64_t shortcut2<int>(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, int sc2, World * world, Vector<int> ** nonleaves, bool create_nonleaves);
+template int64_t unique_pairs<int>(int64_t nprs, Pair<int> * prs, int64_t m);
+template Matrix<int>* PTAP<int>(Matrix<int>* A, Vector<int>* p, int64_t m);
+template Matrix<int>* PTAP_direct<int>(Matrix<int>* A, Vector<int>* p, int64_t m);
+template class Workspace<int>;
+template class JumpPlan<int>;
+template void check_label_range<int>(int64_t n, World* world);
+template int64_t count_cross_edges<int>(Matrix<int>* A, Vector<int>* p);
+template void serial_finish<int>(Matrix<int>* C, Vector<int>* p);
+template Vector<int>* supervertex_matrix<int>(int64_t n, Matrix<int>* A, Vector<int>* p, World* world, int sc2, Workspace<int>* ws, int64_t handoff);
+template Vector<int>* changed_vector<int>(Vector<int> & p, int64_t npairs, Pair<int> * prev_pairs);
+template class PatternCSR<int>;
+template class PatternGrid<int>;
+template Vector<int>* hook_matrix<int>(int64_t n, Matrix<int> * A, World* world, double frontier_frac, int pattern, int64_t hub_deg, int64_t handoff, int max_check);
+template int cyclic_layout<int64_t>(Vector<int64_t> & v, int64_t npairs, Pair<int64_t> const * pairs);
+template void write_local<int64_t>(Vector<int64_t> & p, int64_t npairs, Pair<int64_t> const * pairs, int cyclic);
+template void init_pvector<int64_t>(Vector<int64_t>* p);
+template void read_aligned<int64_t>(Vector<int64_t> & v, int64_t npairs, Pair<int64_t> const * loc_pairs, int64_t * vals);
+template Matrix<int64_t>* pMatrix<int64_t>(Vector<int64_t>* p, World* world);
+template void read_parents<int64_t>(Vector<int64_t> & rec_p, int64_t npairs, Pair<int64_t> const * loc_pairs, int64_t * vals);
+template int64_t max_update<int64_t>(Vector<int64_t> & p, Vector<int64_t> & s, int cyclic);
+template int64_t count_changed<int64_t>(Vector<int64_t> & q, Vector<int64_t> & p);
+template int64_t shortcut<int64_t>(Vector<int64_t> & p, Vector<int64_t> & q, Vector<int64_t> & rec_p, Vector<int64_t> ** nonleaves, bool create_nonleaves);
+template int64_t shortcut_pipelined<int64_t>(Vector<int64_t> & p, Vector<int64_t> & q, Vector<int64_t> & rec_p, int nchunks, Vector<int64_t> ** nonleaves, bool create_nonleaves);
+template int64_t shortcut2<int64_t>(Vector<int64_t> & p, Vector<int64_t> & q, Vector<int64_t> & rec_p, int sc2, World * world, Vector<int64_t> ** nonleaves, bool create_nonleaves);
+template int64_t unique_pairs<int64_t>(int64_t nprs, Pair<int64_t> * prs, int64_t m);
+template Matrix<int64_t>* PTAP<int64_t>(Matrix<int64_t>* A, Vector<int64_t>* p, int64_t m);
+template Matrix<int64_t>* PTAP_direct<int64_t>(Matrix<int64_t>* A, Vector<int64_t>* p, int64_t m);
+template class Workspace<int64_t>;
+template class JumpPlan<int64_t>;
+template void check_label_range<int64_t>(int64_t n, World* world);
+template int64_t count_cross_edges<int64_t>(Matrix<int64_t>* A, Vector<int64_t>* p);
+template void serial_finish<int64_t>(Matrix<int64_t>* C, Vector<int64_t>* p);
+template Vector<int64_t>* supervertex_matrix<int64_t>(int64_t n, Matrix<int64_t>* A, Vector<int64_t>* p, World* world, int sc2, Workspace<int64_t>* ws, int64_t handoff);
+template Vector<int64_t>* changed_vector<int64_t>(Vector<int64_t> & p, int64_t npairs, Pair<int64_t> * prev_pairs);
+template class PatternCSR<int64_t>;
+template class PatternGrid<int64_t>;
+template Vector<int64_t>* hook_matrix<int64_t>(int64_t n, Matrix<int64_t> * A, World* world, double frontier_frac, int pattern, int64_t hub_deg, int64_t handoff, int max_check);
+
+// f[f[i]] = max(f[f[i]], mngf[i]), returns the local number of hooks sent
+int64_t stochastic_hook(Vector<int> & f, Vector<int> & mngf)
+{
+  Timer t_hook("CONNECTIVITY_Stochastic_hook");
+  t_hook.start();
+  int64_t npairs;
+  Pair<int> * loc_pairs;
+  mngf.read_local(&npairs, &loc_pairs);
+  int * f_vals = new int[npairs];
+  read_aligned(f, npairs, loc_pairs, f_vals);
+  //only send the hooks that can raise the parent of f[i]
+  int64_t nhooks = 0;
+  for (int64_t i = 0; i < npairs; i++){
+    if (loc_pairs[i].d > f_vals[i]){
+      loc_pairs[nhooks].k = f_vals[i];
+      loc_pairs[nhooks].d = loc_pairs[i].d;
+      nhooks++;
+    }
+  }
+  //accumulate with the max of MAX_TIMES_SR, so concurrent hooks to the same parent keep the largest
+  f.write(nhooks, 1, 1, loc_pairs);
+  delete [] f_vals;
+  delete [] loc_pairs;
+  t_hook.stop();
+  return nhooks;
+}
+
+// FastSV: hooking and shortcutting on the grandparent vector gf, one relaxation per round
+// if max_check > 1, convergence is only checked every k rounds, with k adapted between 1 and max_check by next_check
+Vector<int>* fastsv_matrix(int n, Matrix<int> * A, World* world, int max_check)
+{
+  auto f = new Vector<int>(n, *world, MAX_TIMES_SR);
+  init_pvector(f);
+  auto gf = new Vector<int>(*f);
+  auto mngf = new Vector<int>(n, *world, MAX_TIMES_SR);
+  //f is never an operand of a contraction, so its layout is fixed
+  int f_cyclic = cyclic_layout(*f);
+
+  //convergence is checked every k rounds, the changes of the last round are reduced together with those since the last check
+  int64_t loc_changes[2] = {0, 0};
+  int64_t changes[2];
+  int k = 1;
+  int rounds = 0;
+  int64_t prev_rate = n;
+  while (true) {
+    Timer t_relax("CONNECTIVITY_Relaxation");
+    t_relax.start();
+    //mngf[i] = max_j A[i,j] * gf[j], the largest grandparent among the neighbors of i
+    (*mngf)["i"] = (*A)["ij"] * (*gf)["j"];
+    t_relax.stop();
+    //stochastic hooking, f[f[i]] = max(f[f[i]], mngf[i])
+    loc_changes[0] = stochastic_hook(*f, *mngf);
+    //aggressive hooking, f[i] = max(f[i], mngf[i])
+    loc_changes[0] += max_update(*f, *mngf, f_cyclic);
+    //shortcutting, f[i] = max(f[i], gf[i])
+    loc_changes[0] += max_update(*f, *gf, f_cyclic);
+    //gf[i] = f[f[i]]
+    shortcut(*gf, *f, *f);
+    loc_changes[1] += loc_changes[0];
+    if (++rounds < k) continue;
+    MPI_Allreduce(loc_changes, changes, 2, MPI_LONG_LONG, MPI_SUM, world->comm);
+    //if f did not change, neither did gf and the next round would do the same
+    if (changes[0] == 0) break;
+    int64_t rate = changes[1] / rounds;
+    k = next_check(k, max_check, rate, prev_rate);
+    prev_rate = rate;
+    rounds = 0;
+    loc_changes[1] = 0;
+  }
+  delete gf;
+  delete mngf;
+  return f;
+}
+
+// sparse vector with entries vals[i] at the keys of loc_pairs where mask[i] != 0
+Vector<int>* masked_vector(Vector<int> & f, int64_t npairs, Pair<int> const * loc_pairs, int const * vals, int const * mask)
+{
+  auto fa = new Vector<int>(f.len, SP, *f.wrld, MAX_TIMES_SR);
+  Pair<int> * fa_pairs = new Pair<int>[npairs];
+  int64_t nfa = 0;
+  for (int64_t i = 0; i < npairs; i++){
+    if (mask[i]){
+      fa_pairs[nfa].k = loc_pairs[i].k;
+      fa_pairs[nfa].d = vals[i];
+      nfa++;
+    }
+  }
+  fa->write(nfa, fa_pairs);
+  delete [] fa_pairs;
+  return fa;
+}
+
+// star[i] = 1 if the tree containing i is a star, if gf_vals is given also returns f[f[i]] for the local pairs of f
+void starcheck(Vector<int> & f, Vector<int> & star, int * gf_vals)
+{
+  Timer t_starcheck("CONNECTIVITY_Starcheck");
+  t_starcheck.start();
+  int64_t npairs;
+  Pair<int> * loc_pairs;
+  f.read_local(&npairs, &loc_pairs);
+  Pair<int> * remote_pairs = new Pair<int>[npairs];
+  for (int64_t i = 0; i < npairs; i++){
+    remote_pairs[i].k = loc_pairs[i].d;
+  }
+  f.read(npairs, remote_pairs); //obtains f[f[i]]
+  //vertices at depth two or more and their roots are not in a star
+  star["i"] = 1;
+  Pair<int> * nonstar_pairs = new Pair<int>[2*npairs];
+  int64_t nnonstar = 0;
+  for (int64_t i = 0; i < npairs; i++){
+    if (loc_pairs[i].d != remote_pairs[i].d){
+      nonstar_pairs[nnonstar++] = Pair<int>(loc_pairs[i].k, 0);
+      nonstar_pairs[nnonstar++] = Pair<int>(remote_pairs[i].d, 0);
+    }
+  }
+  star.write(nnonstar, nonstar_pairs);
+  delete [] nonstar_pairs;
+  //star[i] = star[i] * star[f[i]], which also clears the children of a nonstar root
+  Vector<int> pstar(star.len, *star.wrld, MAX_TIMES_SR);
+  shortcut(pstar, f, star);
+  star["i"] = star["i"] * pstar["i"];
+  if (gf_vals != NULL){
+    for (int64_t i = 0; i < npairs; i++){
+      gf_vals[i] = remote_pairs[i].d;
+    }
+  }
+  delete [] remote_pairs;
+  delete [] loc_pairs;
+  t_starcheck.stop();
+}
+
+// local vertices with hookers[i] != 0 hook their star onto the largest parent among their neighbors with active[j] != 0,
+// if cond only onto parents larger than their own root; sets grown[r] = 1 for every root r that got hooked onto
+void star_hook(Vector<int> & f, Matrix<int> * A, int64_t npairs, Pair<int> const * loc_pairs, int const * active, int const * hookers, bool cond, Vector<int> * grown)
+{
+  Timer t_hook("CONNECTIVITY_Star_hook");
+  t_hook.start();
+  int * f_vals = new int[npairs];
+  read_aligned(f, npairs, loc_pairs, f_vals);
+  //converged and masked vertices do not enter the relaxation
+  auto fa = masked_vector(f, npairs, loc_pairs, f_vals, active);
+  Vector<int> fn(f.len, *f.wrld, MAX_TIMES_SR);
+  Timer t_relax("CONNECTIVITY_Relaxation");
+  t_relax.start();
+  fn["i"] = (*A)["ij"] * (*fa)["j"];
+  t_relax.stop();
+  delete fa;
+  int * fn_vals = new int[npairs];
+  read_aligned(fn, npairs, loc_pairs, fn_vals);
+  //no vertex other than an isolated root 0 has parent 0, so fn[i] = 0 means there is nothing to hook onto
+  Pair<int> * hook_pairs = new Pair<int>[npairs];
+  int64_t nhooks = 0;
+  for (int64_t i = 0; i < npairs; i++){
+    if (hookers[i] && fn_vals[i] != 0 && (!cond || fn_vals[i] > f_vals[i])){
+      hook_pairs[nhooks].k = f_vals[i];
+      hook_pairs[nhooks].d = fn_vals[i];
+      nhooks++;
+    }
+  }
+  //h[r] = max fn[i] over the hooking vertices of the star rooted at r
+  Vector<int> h(f.len, SP, *f.wrld, MAX_TIMES_SR);
+  h.write(nhooks, 1, 1, hook_pairs);
+  delete [] hook_pairs;
+  h.get_local_pairs(&nhooks, &hook_pairs, true);
+  //f[r] = h[r], unconditional hooks may lower the parent of r, so overwrite instead of taking the max
+  f.write(nhooks, hook_pairs);
+  if (grown != NULL){
+    for (int64_t i = 0; i < nhooks; i++){
+      hook_pairs[i].k = hook_pairs[i].d;
+      hook_pairs[i].d = 1;
+    }
+    grown->write(nhooks, hook_pairs);
+  }
+  delete [] hook_pairs;
+  delete [] fn_vals;
+  delete [] f_vals;
+  t_hook.stop();
+}
+
+// LACC: Awerbuch-Shiloach with conditional and unconditional star hooking, starcheck and shortcut,
+// vertices of converged trees are masked out of every later relaxation
+Vector<int>* lacc_matrix(int n, Matrix<int> * A, World* world)
+{
+  auto f = new Vector<int>(n, *world, MAX_TIMES_SR);
+  init_pvector(f);
+  Vector<int> star(n, *world, MAX_TIMES_SR);
+  star["i"] = 1;
+  //the local keys of f do not change, the per-vertex flags below follow their order
+  int64_t npairs;
+  Pair<int> * loc_pairs;
+  f->read_local(&npairs, &loc_pairs);
+  int * conv = new int[npairs]; //conv[i] = 1 once the tree of i is a star without edges leaving it
+  int * stag = new int[npairs]; //stag[i] = 1 if the star of i neither hooked nor got hooked onto
+  int * active = new int[npairs];
+  int * hookers = new int[npairs];
+  int * star_vals = new int[npairs];
+  int * f_vals = new int[npairs];
+  int * f_old = new int[npairs];
+  int * gf_vals = new int[npairs];
+  for (int64_t i = 0; i < npairs; i++){
+    conv[i] = 0;
+  }
+  int64_t nactive = n;
+  while (nactive > 0) {
+    //conditional star hooking onto larger parents
+    read_aligned(star, npairs, loc_pairs, star_vals);
+    for (int64_t i = 0; i < npairs; i++){
+      active[i] = !conv[i];
+      hookers[i] = star_vals[i] && !conv[i];
+    }
+    auto grown = new Vector<int>(n, SP, *world, MAX_TIMES_SR);
+    star_hook(*f, A, npairs, loc_pairs, active, hookers, true, grown);
+    starcheck(*f, star);
+    read_aligned(star, npairs, loc_pairs, star_vals);
+    read_aligned(*f, npairs, loc_pairs, f_old);
+    Pair<int> * remote_pairs = new Pair<int>[npairs];
+    for (int64_t i = 0; i < npairs; i++){
+      remote_pairs[i].k = f_old[i];
+    }
+    grown->read(npairs, remote_pairs); //obtains grown[f[i]]
+    delete grown;
+    for (int64_t i = 0; i < npairs; i++){
+      stag[i] = star_vals[i] && !conv[i] && !remote_pairs[i].d;
+    }
+    delete [] remote_pairs;
+    //unconditional star hooking of stagnant stars, two stagnant stars are never adjacent, so this cannot form cycles
+    for (int64_t i = 0; i < npairs; i++){
+      active[i] = !conv[i] && !stag[i];
+    }
+    star_hook(*f, A, npairs, loc_pairs, active, stag, false);
+    starcheck(*f, star, gf_vals);
+    //a stagnant star that did not hook has no edges leaving it
+    read_aligned(*f, npairs, loc_pairs, f_vals);
+    int64_t loc_nactive = 0;
+    for (int64_t i = 0; i < npairs; i++){
+      if (stag[i] && f_vals[i] == f_old[i] && gf_vals[i] == f_old[i]){
+        conv[i] = 1;
+      }
+      loc_nactive += !conv[i];
+    }
+    MPI_Allreduce(&loc_nactive, &nactive, 1, MPI_LONG_LONG, MPI_SUM, world->comm);
+    //shortcut the active vertices of nonstar trees
+    read_aligned(star, npairs, loc_pairs, star_vals);
+    for (int64_t i = 0; i < npairs; i++){
+      active[i] = !conv[i] && !star_vals[i];
+    }
+    auto fa = masked_vector(*f, npairs, loc_pairs, f_vals, active);
+    shortcut(*f, *fa, *f);
+    delete fa;
+    starcheck(*f, star);
+  }
+  //label every star by its largest vertex, as hook_matrix does
+  read_aligned(*f, npairs, loc_pairs, f_vals);
+  for (int64_t i = 0; i < npairs; i++){
+    loc_pairs[i].d = loc_pairs[i].k;
+    loc_pairs[i].k = f_vals[i];
+  }
+  Vector<int> max_label(n, *world, MAX_TIMES_SR);
+  max_label.write(npairs, 1, 1, loc_pairs);
+  shortcut(*f, *f, max_label);
+
+  delete [] conv;
+  delete [] stag;
+  delete [] active;
+  delete [] hookers;
+  delete [] star_vals;
+  delete [] f_vals;
+  delete [] f_old;
+  delete [] gf_vals;
+  delete [] loc_pairs;
+  return f;
+}
+// hook_matrix (engine 0) or supervertex_matrix (engine 1) starting from p[i] = i
+Vector<int>* solve_matrix(int n, Matrix<int> * A, World* world, int engine, int sc2)
+{
+  if (engine == 0) {
+    return hook_matrix(n, A, world);
+  }
+  auto p = new Vector<int>(n, *world, MAX_TIMES_SR);
+  init_pvector(p);
+  return supervertex_matrix(n, A, p, world, sc2);
+}
+
+// sequential union-find with path halving
+int64_t uf_find(int64_t * parent, int64_t x)
+{
+  while (parent[x] != x){
+    parent[x] = parent[parent[x]];
+    x = parent[x];
+  }
+  return x;
+}
+
+// links the smaller root under the larger one, so the root of every set is its largest element
+void uf_union(int64_t * parent, int64_t x, int64_t y)
+{
+  x = uf_find(parent, x);
+  y = uf_find(parent, y);
+  if (x < y) parent[x] = y;
+  else if (y < x) parent[y] = x;
+}
+
+// contracts the locally stored edges of A with a sequential union-find, the representative of a local component is its largest vertex
+// returns the edges (v, rep(v)) for the vertices v that also appear on other ranks, and in rep_map the pairs (v, rep(v)) of the others
+Matrix<int>* local_contract(int n, Matrix<int> * A, int64_t * nmap, Pair<int> ** rep_map)
+{
+  Timer t_contract("CONNECTIVITY_Local_contract");
+  t_contract.start();
+  int64_t nprs;
+  Pair<int> * prs;
+  A->get_local_pairs(&nprs, &prs, true);
+  //compact the local vertices, sorting keeps their order so the largest index is the largest vertex
+  int64_t * verts = new int64_t[2*nprs];
+  for (int64_t i = 0; i < nprs; i++){
+    verts[2*i] = prs[i].k % n;
+    verts[2*i+1] = prs[i].k / n;
+  }
+  std::sort(verts, verts + 2*nprs);
+  int64_t nv = std::unique(verts, verts + 2*nprs) - verts;
+  int64_t * parent = new int64_t[nv];
+  for (int64_t v = 0; v < nv; v++){
+    parent[v] = v;
+  }
+  for (int64_t i = 0; i < nprs; i++){
+    int64_t r = std::lower_bound(verts, verts + nv, prs[i].k % n) - verts;
+    int64_t c = std::lower_bound(verts, verts + nv, prs[i].k / n) - verts;
+    uf_union(parent, r, c);
+  }
+  delete [] prs;
+
+  //vertices touched by more than one rank link the local components across ranks
+  Vector<int> touched(n, *A->wrld);
+  Pair<int> * v_pairs = new Pair<int>[nv];
+  for (int64_t v = 0; v < nv; v++){
+    v_pairs[v] = Pair<int>(verts[v], 1);
+  }
+  touched.write(nv, 1, 1, v_pairs);
+  touched.read(nv, v_pairs);
+  Pair<int> * edge_prs = new Pair<int>[2*nv];
+  int64_t nedges = 0;
+  *rep_map = new Pair<int>[nv];
+  *nmap = 0;
+  for (int64_t v = 0; v < nv; v++){
+    int64_t rep = verts[uf_find(parent, v)];
+    if (rep == verts[v]) continue;
+    if (v_pairs[v].d > 1){
+      edge_prs[nedges++] = Pair<int>(verts[v] + rep * n, 1);
+      edge_prs[nedges++] = Pair<int>(rep + verts[v] * n, 1);
+    } else {
+      (*rep_map)[(*nmap)++] = Pair<int>(verts[v], rep);
+    }
+  }
+  auto C = new Matrix<int>(n, n, SP, *A->wrld, MAX_TIMES_SR);
+  C->write(nedges, edge_prs);
+  delete [] edge_prs;
+  delete [] v_pairs;
+  delete [] parent;
+  delete [] verts;
+  t_contract.stop();
+  return C;
+}
+
+// p[v] = p[rep(v)] for the pairs (v, rep(v)) of rep_map
+void apply_rep_map(Vector<int> * p, int64_t nmap, Pair<int> const * rep_map)
+{
+  Pair<int> * remote_pairs = new Pair<int>[nmap];
+  for (int64_t i = 0; i < nmap; i++){
+    remote_pairs[i].k = rep_map[i].d;
+  }
+  p->read(nmap, remote_pairs);
+  for (int64_t i = 0; i < nmap; i++){
+    remote_pairs[i].k = rep_map[i].k;
+  }
+  p->write(nmap, remote_pairs);
+  delete [] remote_pairs;
+}
+
+// contract the edges each rank owns before running hook_matrix (engine 0) or supervertex_matrix (engine 1)
+Vector<int>* contract_matrix(int n, Matrix<int> * A, World* world, int engine, int sc2)
+{
+  int64_t nmap;
+  Pair<int> * rep_map;
+  auto C = local_contract(n, A, &nmap, &rep_map);
+  if (world->rank == 0)
+    printf("Local contraction leaves %ld of %ld edges\n", C->nnz_tot, A->nnz_tot);
+  auto p = solve_matrix(n, C, world, engine, sc2);
+  delete C;
+  apply_rep_map(p, nmap, rep_map);
+  delete [] rep_map;
+  return p;
+}
+
+// concurrent find with path halving, parent[x] >= x always holds, so replacing a parent by its own parent is safe under races
+int64_t uf_cas_find(int64_t * parent, int64_t x)
+{
+  while (true){
+    int64_t px = __atomic_load_n(&parent[x], __ATOMIC_RELAXED);
+    if (px == x) return x;
+    int64_t gx = __atomic_load_n(&parent[px], __ATOMIC_RELAXED);
+    if (px == gx) return px;
+    __sync_bool_compare_and_swap(&parent[x], px, gx);
+    x = gx;
+  }
+}
+
+// concurrent union, the smaller root is linked under the larger one with a CAS that fails if it stopped being a root
+void uf_cas_union(int64_t * parent, int64_t x, int64_t y)
+{
+  while (true){
+    x = uf_cas_find(parent, x);
+    y = uf_cas_find(parent, y);
+    if (x == y) return;
+    if (x > y) std::swap(x, y);
+    if (__sync_bool_compare_and_swap(&parent[x], x, y)) return;
+  }
+}
+
+// shared-memory lock-free union-find over the edges (edges[2*i], edges[2*i+1]) as produced by read_graph/gen_graph,
+// returns labels[i] = largest vertex in the component of i, the convention of hook_matrix
+int64_t * uf_omp(int64_t n, uint64_t nedges, uint64_t const * edges)
+{
+  Timer t_uf("CONNECTIVITY_UF_omp");
+  t_uf.start();
+  int64_t * parent = new int64_t[n];
+  #pragma omp parallel for
+  for (int64_t v = 0; v < n; v++){
+    parent[v] = v;
+  }
+  #pragma omp parallel for schedule(dynamic, 4096)
+  for (int64_t i = 0; i < (int64_t)nedges; i++){
+    uf_cas_union(parent, edges[2*i], edges[2*i+1]);
+  }
+  #pragma omp parallel for
+  for (int64_t v = 0; v < n; v++){
+    parent[v] = uf_cas_find(parent, v);
+  }
+  t_uf.stop();
+  return parent;
+}
+
+// runs uf_omp on every rank over all edges of A, intended for single-node runs with one rank, which holds all of A anyway
+Vector<int>* uf_omp_matrix(int n, Matrix<int> * A, World* world)
+{
+  int64_t nprs;
+  Pair<int> * prs;
+  A->get_all_pairs(&nprs, &prs, true);
+  uint64_t * edges = new uint64_t[2*nprs];
+  for (int64_t i = 0; i < nprs; i++){
+    edges[2*i] = prs[i].k % n;
+    edges[2*i+1] = prs[i].k / n;
+  }
+  delete [] prs;
+  int64_t * labels = uf_omp(n, nprs, edges);
+  delete [] edges;
+  auto p = new Vector<int>(n, *world, MAX_TIMES_SR);
+  int64_t npairs;
+  Pair<int> * loc_pairs;
+  p->read_local(&npairs, &loc_pairs);
+  for (int64_t i = 0; i < npairs; i++){
+    loc_pairs[i].d = labels[loc_pairs[i].k];
+  }
+  write_local(*p, npairs, loc_pairs);
+  delete [] loc_pairs;
+  delete [] labels;
+  return p;
+}
+
+// symmetric matrix with the edges to the first k (locally stored) neighbors of every vertex of A
+Matrix<int>* sample_neighbors(int n, Matrix<int> * A, int k)
+{
+  int64_t nprs;
+  Pair<int> * prs;
+  A->get_local_pairs(&nprs, &prs, true);
+  Pair<int> * sample_prs = new Pair<int>[2*nprs];
+  int64_t nsample = 0;
+  int64_t col = -1;
+  int nbrs = 0;
+  //pairs are stored by column, so the neighbors of vertex j = k/n are consecutive
+  for (int64_t i = 0; i < nprs; i++){
+    if (prs[i].k / n != col){
+      col = prs[i].k / n;
+      nbrs = 0;
+    }
+    if (nbrs < k){
+      sample_prs[nsample++] = Pair<int>(prs[i].k, 1);
+      sample_prs[nsample++] = Pair<int>((prs[i].k % n) * n + col, 1);
+      nbrs++;
+    }
+  }
+  auto S = new Matrix<int>(n, n, SP, *A->wrld, MAX_TIMES_SR);
+  S->write(nsample, sample_prs);
+  delete [] sample_prs;
+  delete [] prs;
+  return S;
+}
+
+// most frequent label among nsamples random entries of p, every rank samples the same vertices
+int largest_component(Vector<int> * p, int nsamples)
+{
+  Pair<int> * sample_pairs = new Pair<int>[nsamples];
+  srand48(SEED);
+  for (int i = 0; i < nsamples; i++){
+    sample_pairs[i].k = lrand48() % p->len;
+  }
+  p->read(nsamples, sample_pairs);
+  std::sort(sample_pairs, sample_pairs + nsamples, [](const Pair<int> & a, const Pair<int> & b){ return a.d < b.d; });
+  int c = sample_pairs[0].d;
+  int c_cnt = 0;
+  int cnt = 0;
+  for (int i = 0; i < nsamples; i++){
+    cnt = (i > 0 && sample_pairs[i].d == sample_pairs[i-1].d) ? cnt+1 : 1;
+    if (cnt > c_cnt){
+      c = sample_pairs[i].d;
+      c_cnt = cnt;
+    }
+  }
+  delete [] sample_pairs;
+  return c;
+}
+
+// A with the vertices i of component c of p (p[i] = c) merged into c, edges inside c are dropped
+Matrix<int>* collapse_component(int n, Matrix<int> * A, Vector<int> * p, int c)
+{
+  int64_t nprs;
+  Pair<int> * prs;
+  A->get_local_pairs(&nprs, &prs, true);
+  Pair<int> * row_pairs = new Pair<int>[nprs];
+  Pair<int> * col_pairs = new Pair<int>[nprs];
+  for (int64_t i = 0; i < nprs; i++){
+    row_pairs[i].k = prs[i].k % n;
+    col_pairs[i].k = prs[i].k / n;
+  }
+  p->read(nprs, row_pairs);
+  p->read(nprs, col_pairs);
+  int64_t nrest = 0;
+  for (int64_t i = 0; i < nprs; i++){
+    if (row_pairs[i].d != c || col_pairs[i].d != c){
+      int64_t row = (row_pairs[i].d == c) ? c : row_pairs[i].k;
+      int64_t col = (col_pairs[i].d == c) ? c : col_pairs[i].k;
+      prs[nrest++] = Pair<int>(row + col * (int64_t)n, 1);
+    }
+  }
+  delete [] row_pairs;
+  delete [] col_pairs;
+  auto R = new Matrix<int>(n, n, SP, *A->wrld, MAX_TIMES_SR);
+  R->write(nrest, prs);
+  delete [] prs;
+  return R;
+}
+
+// Afforest: link the first k neighbors of every vertex with nrounds hook and shortcut rounds, find the largest intermediate
+// component by sampling, then run hook_matrix (engine 0) or supervertex_matrix (engine 1) on A with that component merged into one vertex
+Vector<int>* afforest_matrix(int n, Matrix<int> * A, World* world, int engine, int sc2, int k, int nsamples, int nrounds)
+{
+  Timer t_sample("CONNECTIVITY_Afforest_sample");
+  t_sample.start();
+  double stime = MPI_Wtime();
+  auto S = sample_neighbors(n, A, k);
+  //no convergence loop, p[i] only has to be a vertex connected to i
+  auto p = new Vector<int>(n, *world, MAX_TIMES_SR);
+  init_pvector(p);
+  Vector<int> q(n, *world, MAX_TIMES_SR);
+  for (int r = 0; r < nrounds; r++){
+    q["i"] = (*S)["ij"] * (*p)["j"];
+    max_update(*p, q);
+    shortcut(*p, *p, *p);
+  }
+  delete S;
+  int c = largest_component(p, nsamples);
+  auto R = collapse_component(n, A, p, c);
+  t_sample.stop();
+  if (world->rank == 0)
+    printf("Afforest merges component %d in %1.2lf s, %ld of %ld edges remain\n", c, MPI_Wtime() - stime, R->nnz_tot, A->nnz_tot);
+
+  auto rp = solve_matrix(n, R, world, engine, sc2);
+  delete R;
+  //the merged vertices take the label of c
+  Pair<int> c_pair;
+  c_pair.k = c;
+  rp->read(1, &c_pair);
+  int64_t npairs;
+  Pair<int> * loc_pairs;
+  p->read_local(&npairs, &loc_pairs);
+  int * vals = new int[npairs];
+  read_aligned(*rp, npairs, loc_pairs, vals);
+  for (int64_t i = 0; i < npairs; i++){
+    loc_pairs[i].d = (loc_pairs[i].d == c) ? c_pair.d : vals[i];
+  }
+  write_local(*rp, npairs, loc_pairs);
+  delete [] vals;
+  delete [] loc_pairs;
+  delete p;
+  return rp;
+}
 
 std::vector< Matrix<int>* > batch_subdivide(Matrix<int> & A, std::vector<float> batch_fracs){
   Matrix<float> B(A.nrow, A.ncol, SP*A.is_sparse, *A.wrld, MAX_TIMES_SR);
@@ -4,6 +4,7 @@
 #include <ctf.hpp>
 #include <float.h>
 #include <math.h>
+#include <unordered_map>
 #include "graph_aux.h"
 
 using namespace CTF;
@@ -28,6 +29,24 @@ static Semiring<int> MAX_TIMES_SR(0,
     return a * b;
     });
 
+static Semiring<int64_t> MAX_TIMES_SR64(0,
+    [](int64_t a, int64_t b) {
+    return std::max(a, b);
+    },
+    MPI_MAX,
+    1,
+    [](int64_t a, int64_t b) {
+    return a * b;
+    });
+
+// max-times semiring and MPI datatype for the label type T of the connectivity engines
+template <typename T> Semiring<T> & max_times_sr();
+template <> inline Semiring<int> & max_times_sr<int>() { return MAX_TIMES_SR; }
+template <> inline Semiring<int64_t> & max_times_sr<int64_t>() { return MAX_TIMES_SR64; }
+template <typename T> MPI_Datatype mpi_type();
+template <> inline MPI_Datatype mpi_type<int>() { return MPI_INT; }
+template <> inline MPI_Datatype mpi_type<int64_t>() { return MPI_INT64_T; }
+
 class Int64Pair {
   public:
     int64_t i1;
@@ -48,24 +67,197 @@ class Graph {
     Matrix<int>* adjacencyMatrix(World* world, bool sparse = false);
 };
 
-// Connectivity
-Vector<int>* hook_matrix(int n, Matrix<int> * A, World* world);
-Vector<int>* supervertex_matrix(int n, Matrix<int>* A, Vector<int>* p, World* world, int sc2);
+// communication plan for repeated pointer jumping p[i] = p[p[i]] on a cyclically distributed vector,
+// owners and offsets of parents are computed directly and only vertices whose parent is not yet a root stay in the plan
+// with multihop, remote parents fetched in earlier rounds are cached so that several hops can resolve without communication
+template <typename T>
+class JumpPlan {
+  public:
+    Vector<T>* p;
+    bool aligned;
+    int64_t nloc;
+    Pair<T>* loc_pairs;
+    int64_t nactive;
+    int64_t* active;
+    bool* changed;
+    int* send_counts;
+    int* send_displs;
+    int* recv_counts;
+    int* recv_displs;
+    T* keys;
+    T* serve;
+    bool multihop;
+    std::unordered_map<T, T> cache;
+
+    JumpPlan(Vector<T>* p, bool multihop=false, int cyclic=-1);
+    ~JumpPlan();
+
+    T resolve(T c, bool* root);
+    int64_t exchange(int64_t nkeys, T*& vals);
+    int64_t jump();
+    void finish();
+};
+
+// pool of dense label vectors and a scratch Pair buffer that solvers reuse across iterations and recursion levels,
+// vectors are handed out with stale entries, so callers overwrite every entry
+template <typename T>
+class Workspace {
+  public:
+    World* world;
+    std::vector< Vector<T>* > free_vecs;
+    Pair<T>* buf;
+    int64_t buf_len;
+
+    Workspace(World* world);
+    ~Workspace();
+
+    Vector<T>* vec(int64_t n, bool sparse=false);
+    void release(Vector<T>* v);
+    Pair<T>* pairs(int64_t n);
+};
+
+// pattern of the rows of A owned by this rank under the cyclic layout of p (row rank + i*np is local row i), stored as CSR
+// without values, columns index a list of distinct ghost vertices whose labels are fetched with a fixed exchange plan
+// rows with at least hub_deg nonzeros (if hub_deg > 0) are hubs, their labels are replicated and their rows split over all ranks
+// column indices have the label type T, so the int64_t instantiation is not limited to 2^31 ghost columns
+template <typename T>
+class PatternCSR {
+  public:
+    Matrix<T>* A;
+    int64_t n;
+    int64_t nrows;
+    int64_t* row_ptr;
+    T* col_idx;
+    int64_t nghosts;
+    T* ghosts;
+    int* req_counts;
+    int* req_displs;
+    int* srv_counts;
+    int* srv_displs;
+    int64_t nserve;
+    int64_t* serve;
+    int64_t nhubs;
+    T* hubs;
+    int64_t* hub_ptr;
+    T* hub_idx;
+
+    PatternCSR(Matrix<T>* A, int64_t hub_deg=0);
+    ~PatternCSR();
+
+    void relax(Vector<T>& p, Vector<T>& r);
+};
+
+// pattern of A laid out on a pr x pc process grid (rank = row*pc + col), for the cyclic layout of p the rank at grid position (a,b)
+// holds A[i,j] for the vertices i owned by grid row a and j owned by grid column b, a relaxation is an allgather of p along the
+// grid column (expand), a local CSR max and a max reduce-scatter along the grid row (fold)
+template <typename T>
+class PatternGrid {
+  public:
+    Matrix<T>* A;
+    int64_t n;
+    int pr;
+    int pc;
+    MPI_Comm row_comm;
+    MPI_Comm col_comm;
+    int64_t nrows;
+    int64_t ncols;
+    int64_t* row_ptr;
+    T* col_idx;
+    int* row_counts;
+    int* col_counts;
+    int* col_displs;
+
+    PatternGrid(Matrix<T>* A);
+    ~PatternGrid();
+
+    void relax(Vector<T>& p, Vector<T>& r);
+};
+
+// Connectivity, the engines templated on the label type T are instantiated for int and int64_t
+template <typename T>
+Vector<T>* hook_matrix(int64_t n, Matrix<T> * A, World* world, double frontier_frac=0., int pattern=0, int64_t hub_deg=0, int64_t handoff=0, int max_check=1);
+template <typename T>
+Vector<T>* supervertex_matrix(int64_t n, Matrix<T>* A, Vector<T>* p, World* world, int sc2, Workspace<T>* ws=NULL, int64_t handoff=0);
+Vector<int>* fastsv_matrix(int n, Matrix<int> * A, World* world, int max_check=1);
+Vector<int>* lacc_matrix(int n, Matrix<int> * A, World* world);
+Vector<int>* afforest_matrix(int n, Matrix<int> * A, World* world, int engine, int sc2, int k=2, int nsamples=1024, int nrounds=2);
+Vector<int>* contract_matrix(int n, Matrix<int> * A, World* world, int engine, int sc2);
+int64_t * uf_omp(int64_t n, uint64_t nedges, uint64_t const * edges);
+Vector<int>* uf_omp_matrix(int n, Matrix<int> * A, World* world);
 
 // Utility functions
 template <typename dtype>
 int64_t are_vectors_different(CTF::Vector<dtype> & A, CTF::Vector<dtype> & B);
 template <typename dtype>
 void max_vector(CTF::Vector<dtype> & result, CTF::Vector<dtype> & A, CTF::Vector<dtype> & B);
-void init_pvector(Vector<int>* p);
-Matrix<int>* pMatrix(Vector<int>* p, World* world);
+template <typename T>
+int cyclic_layout(Vector<T> & v, int64_t npairs=0, Pair<T> const * pairs=NULL);
+template <typename T>
+void write_local(Vector<T> & p, int64_t npairs, Pair<T> const * pairs, int cyclic=-1);
+template <typename T>
+void init_pvector(Vector<T>* p);
+template <typename T>
+void read_parents(Vector<T> & rec_p, int64_t npairs, Pair<T> const * loc_pairs, T * vals);
+template <typename T>
+int64_t max_update(Vector<T> & p, Vector<T> & s, int cyclic=-1);
+template <typename T>
+void check_label_range(int64_t n, World* world);
+template <typename T>
+int64_t count_cross_edges(Matrix<T>* A, Vector<T>* p);
+template <typename T>
+void serial_finish(Matrix<T>* C, Vector<T>* p);
+template <typename T>
+int64_t count_changed(Vector<T> & q, Vector<T> & p);
+template <typename T>
+void read_aligned(Vector<T> & v, int64_t npairs, Pair<T> const * loc_pairs, T * vals);
+template <typename T>
+Vector<T>* changed_vector(Vector<T> & p, int64_t npairs, Pair<T> * prev_pairs);
+int64_t stochastic_hook(Vector<int> & f, Vector<int> & mngf);
+Vector<int>* masked_vector(Vector<int> & f, int64_t npairs, Pair<int> const * loc_pairs, int const * vals, int const * mask);
+void starcheck(Vector<int> & f, Vector<int> & star, int * gf_vals=NULL);
+Vector<int>* solve_matrix(int n, Matrix<int> * A, World* world, int engine, int sc2);
+int64_t uf_find(int64_t * parent, int64_t x);
+void uf_union(int64_t * parent, int64_t x, int64_t y);
+Matrix<int>* local_contract(int n, Matrix<int> * A, int64_t * nmap, Pair<int> ** rep_map);
+void apply_rep_map(Vector<int> * p, int64_t nmap, Pair<int> const * rep_map);
+int64_t uf_cas_find(int64_t * parent, int64_t x);
+void uf_cas_union(int64_t * parent, int64_t x, int64_t y);
+Matrix<int>* sample_neighbors(int n, Matrix<int> * A, int k);
+int largest_component(Vector<int> * p, int nsamples);
+Matrix<int>* collapse_component(int n, Matrix<int> * A, Vector<int> * p, int c);
+void star_hook(Vector<int> & f, Matrix<int> * A, int64_t npairs, Pair<int> const * loc_pairs, int const * active, int const * hookers, bool cond, Vector<int> * grown=NULL);
+template <typename T>
+Matrix<T>* pMatrix(Vector<T>* p, World* world);
 //void shortcut(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, Vector<int> *& leaves);
-void shortcut(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, Vector<int> ** nonleaves=NULL, bool create_nonleaves=false);
+template <typename T>
+int64_t shortcut(Vector<T> & p, Vector<T> & q, Vector<T> & rec_p, Vector<T> ** nonleaves=NULL, bool create_nonleaves=false);
 std::vector< Matrix<int>* > batch_subdivide(Matrix<int> & A, std::vector<float> batch_fracs);
-void shortcut2(Vector<int> & p, Vector<int> & q, Vector<int> & rec_p, int sc2, World * world, Vector<int> ** nonleaves=NULL, bool create_nonleaves=false);
-void roots_num(int64_t npairs, Pair<int> * loc_pairs, int64_t * loc_roots_num, int64_t * global_roots_num,  World * world);
-void roots(int64_t npairs, int64_t loc_roots_num, Pair<int> * loc_pairs, int64_t * global_roots_num, int * global_roots,  World * world);
-void create_nontriv_loc_indices(int64_t *& nontriv_loc_indices, int64_t * loc_nontriv_num, int64_t * global_roots_num, int * global_roots, int64_t q_npairs, Pair<int> * q_loc_pairs, World * world);
+template <typename T>
+int64_t shortcut_pipelined(Vector<T> & p, Vector<T> & q, Vector<T> & rec_p, int nchunks=4, Vector<T> ** nonleaves=NULL, bool create_nonleaves=false);
+template <typename T>
+int64_t shortcut2(Vector<T> & p, Vector<T> & q, Vector<T> & rec_p, int sc2, World * world, Vector<T> ** nonleaves=NULL, bool create_nonleaves=false);
+template <typename T>
+int64_t unique_pairs(int64_t nprs, Pair<T> * prs, int64_t m=-1);
+template <typename T>
+int64_t compact_keys(int64_t n, int64_t npairs, Pair<T> const * pairs, T * ids, World * world);
+template <typename T>
+void read_compact(Vector<T> & cidx, int64_t npairs, Pair<T> const * loc_pairs, T * vals);
+template <typename T>
+void roots_num(int64_t npairs, Pair<T> * loc_pairs, int64_t * loc_roots_num, int64_t * global_roots_num,  World * world);
+template <typename T>
+void roots(int64_t npairs, int64_t loc_roots_num, Pair<T> * loc_pairs, int64_t * global_roots_num, T * global_roots,  World * world);
+int64_t root_slot(int64_t key, int64_t nslots);
+int next_check(int k, int max_k, int64_t rate, int64_t prev_rate);
+template <typename T>
+Matrix<T>* PTAP(Matrix<T>* A, Vector<T>* p, int64_t m=-1);
+template <typename T>
+Matrix<T>* PTAP_direct(Matrix<T>* A, Vector<T>* p, int64_t m=-1);
+template <typename T>
+void roots_bitmap(int64_t npairs, Pair<T> * loc_pairs, int64_t n, uint32_t * root_bits, World * world);
+template <typename T>
+void create_nontriv_loc_indices_bitmap(int64_t *& nontriv_loc_indices, int64_t * loc_nontriv_num, uint32_t const * root_bits, int64_t q_npairs, Pair<T> * q_loc_pairs);
+template <typename T>
+void create_nontriv_loc_indices(int64_t *& nontriv_loc_indices, int64_t * loc_nontriv_num, int64_t * global_roots_num, T * global_roots, int64_t q_npairs, Pair<T> * q_loc_pairs, World * world);
 
 // FIXME: below functions are yet to be optimized/reviewed
 // ---------------------------
@@ -390,7 +390,103 @@ int64_t serial_connectivity(Matrix<int>* A)
   return connected_components;
 }
 
-void run_connectivity(Matrix<int>* A, int64_t matSize, World *w, int batch, int shortcut, int run_serial)
+// B[k] = (U)A[k] for the local nonzeros of A, B has the shape of A
+template <typename U, typename T>
+void convert_labels(Tensor<T> & A, Tensor<U> & B)
+{
+  int64_t npairs;
+  Pair<T> * loc_pairs;
+  A.get_local_pairs(&npairs, &loc_pairs, true);
+  Pair<U> * u_pairs = new Pair<U>[npairs];
+  for (int64_t i = 0; i < npairs; i++){
+    u_pairs[i].k = loc_pairs[i].k;
+    u_pairs[i].d = (U)loc_pairs[i].d;
+  }
+  B.write(npairs, u_pairs);
+  delete [] u_pairs;
+  delete [] loc_pairs;
+}
+
+// run one of the additional engines selected with -engine
+Vector<int>* run_engine(char const * engine, Matrix<int>* A, int64_t matSize, World *w, int shortcut)
+{
+  if (strcmp(engine, "hook_frontier") == 0) {
+    return hook_matrix(matSize, A, w, 0.1);
+  }
+  if (strcmp(engine, "hook_pattern") == 0) {
+    return hook_matrix(matSize, A, w, 0., 1);
+  }
+  if (strcmp(engine, "hook_hubs") == 0) {
+    //hubs have at least 16 times the average degree
+    int64_t npairs, nnz;
+    Pair<int> * loc_pairs;
+    A->get_local_pairs(&npairs, &loc_pairs, true);
+    delete [] loc_pairs;
+    MPI_Allreduce(&npairs, &nnz, 1, MPI_LONG_LONG, MPI_SUM, w->comm);
+    return hook_matrix(matSize, A, w, 0., 1, 16 * nnz / matSize + 1);
+  }
+  if (strcmp(engine, "hook_grid") == 0) {
+    return hook_matrix(matSize, A, w, 0., 2);
+  }
+  if (strcmp(engine, "fastsv") == 0) {
+    return fastsv_matrix(matSize, A, w);
+  }
+  if (strcmp(engine, "fastsv_lazy") == 0) {
+    return fastsv_matrix(matSize, A, w, 16);
+  }
+  if (strcmp(engine, "hook_lazy") == 0) {
+    return hook_matrix(matSize, A, w, 0., 0, 0, 0, 16);
+  }
+  if (strcmp(engine, "lacc") == 0) {
+    return lacc_matrix(matSize, A, w);
+  }
+  if (strcmp(engine, "afforest_hook") == 0) {
+    return afforest_matrix(matSize, A, w, 0, shortcut);
+  }
+  if (strcmp(engine, "afforest_sv") == 0) {
+    return afforest_matrix(matSize, A, w, 1, shortcut);
+  }
+  if (strcmp(engine, "contract_hook") == 0) {
+    return contract_matrix(matSize, A, w, 0, shortcut);
+  }
+  if (strcmp(engine, "contract_sv") == 0) {
+    return contract_matrix(matSize, A, w, 1, shortcut);
+  }
+  if (strcmp(engine, "hook_handoff") == 0) {
+    return hook_matrix(matSize, A, w, 0., 0, 0, 4096);
+  }
+  if (strcmp(engine, "sv_handoff") == 0) {
+    auto p = new Vector<int>(matSize, *w, MAX_TIMES_SR);
+    init_pvector(p);
+    return supervertex_matrix(matSize, A, p, w, shortcut, (Workspace<int>*)NULL, 4096);
+  }
+  if (strcmp(engine, "uf_omp") == 0) {
+    //every rank would hold a copy of all edges
+    if (w->np > 1) {
+      if (w->rank == 0) {
+        printf("uf_omp is a shared-memory engine, run it with a single rank\n");
+      }
+      return NULL;
+    }
+    return uf_omp_matrix(matSize, A, w);
+  }
+  if (strcmp(engine, "hook64") == 0) {
+    //64-bit labels, the result is converted back for the comparison
+    Matrix<int64_t> A64(matSize, matSize, SP*A->is_sparse, *w, MAX_TIMES_SR64);
+    convert_labels(*A, A64);
+    auto p64 = hook_matrix(matSize, &A64, w);
+    auto p = new Vector<int>(matSize, *w, MAX_TIMES_SR);
+    convert_labels(*p64, *p);
+    delete p64;
+    return p;
+  }
+  if (w->rank == 0) {
+    printf("Unknown engine %s\n", engine);
+  }
+  return NULL;
+}
+
+void run_connectivity(Matrix<int>* A, int64_t matSize, World *w, int batch, int shortcut, int run_serial, char const * engine)
 {
   matSize = A->nrow; // Quick fix to avoid change in i/p matrix size after preprocessing
   double stime;
@@ -413,6 +509,30 @@ void run_connectivity(Matrix<int>* A, int64_t matSize, World *w, int batch, int
     printf("Found %ld components with hook_matrix, pg is of length %d, hm of length %d, matSize is %ld.\n",cnt,pg->len,hm->len,matSize);
   }
 
+  if (engine != NULL) {
+    Timer_epoch te(engine);
+    te.begin();
+    stime = MPI_Wtime();
+    auto ev = run_engine(engine, A, matSize, w, shortcut);
+    etime = MPI_Wtime();
+    te.end();
+    if (ev != NULL) {
+      if (w->rank == 0) {
+        printf("Time for %s: %1.2lf\n", engine, (etime - stime));
+      }
+      int64_t result = are_vectors_different(*hm, *ev);
+      if (w->rank == 0) {
+        if (result) {
+          printf("hook_matrix and %s result vectors are different by %ld: FAIL\n", engine, result);
+        }
+        else {
+          printf("hook_matrix and %s result vectors are same: PASS\n", engine);
+        }
+      }
+      delete ev;
+    }
+  }
+
   auto p = new Vector<int>(matSize, *w, MAX_TIMES_SR);
   init_pvector(p);
   Timer_epoch tsv("super_vertex");
@@ -503,6 +623,7 @@ int main(int argc, char** argv)
   int batch;
   int sc2;
   int run_serial;
+  char *engine;
 
   int k;
   if (getCmdOption(input_str, input_str+in_num, "-k")) {
@@ -546,6 +667,9 @@ int main(int argc, char** argv)
     run_serial = atoi(getCmdOption(input_str, input_str+in_num, "-serial"));
     if (run_serial < 0) run_serial = 0;
   } else run_serial = 0;
+  if (getCmdOption(input_str, input_str+in_num, "-engine")){
+    engine = getCmdOption(input_str, input_str+in_num, "-engine");
+  } else engine = NULL;
 
   if (gfile != NULL){
     int n_nnz = 0;
@@ -553,7 +677,7 @@ int main(int argc, char** argv)
       printf("Reading real graph n = %lld\n", n);
     Matrix<wht> A = read_matrix(*w, n, gfile, prep, &n_nnz);
     // A.print_matrix();
-    run_connectivity(&A, n, w, batch, sc2, run_serial);
+    run_connectivity(&A, n, w, batch, sc2, run_serial, engine);
   }
   else if (k != -1) {
     int64_t matSize = pow(3, k);
@@ -562,7 +686,7 @@ int main(int argc, char** argv)
     if (w->rank == 0) {
       printf("Running connectivity on Kronecker graph K: %d matSize: %ld\n", k, matSize);
     }
-    run_connectivity(B, matSize, w, batch, sc2, run_serial);
+    run_connectivity(B, matSize, w, batch, sc2, run_serial, engine);
     delete B;
   }
   else if (scale > 0 && ef > 0){
@@ -572,7 +696,7 @@ int main(int argc, char** argv)
       printf("R-MAT scale = %d ef = %d seed = %lu\n", scale, ef, myseed);
     Matrix<wht> A = gen_rmat_matrix(*w, scale, ef, myseed, prep, &n_nnz, max_ewht);
     int64_t matSize = A.nrow; 
-    run_connectivity(&A, matSize, w, batch, sc2, run_serial);
+    run_connectivity(&A, matSize, w, batch, sc2, run_serial, engine);
   }
   else {
     if (w->rank == 0) {